@@ -0,0 +1,56 @@
+#include "simulation.hpp"
+#include "water_query.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Mesure le débit de l'API de requêtes : water_query_bench [taille_grille] [nb_points]
+int main(int argc, char **argv)
+{
+  int N = argc > 1 ? std::atoi(argv[1]) : 1024;
+  size_t count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4000000;
+  float step = 1.0f;
+
+  Simulation sim(N, step, 0.016f, 0.995f);
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> cellDist(0, N);
+  for (int k = 0; k < 20; ++k)
+  {
+    sim.addDrop(cellDist(rng), cellDist(rng), -1.5f, 5);
+    sim.update();
+  }
+
+  SurfacePublisher publisher;
+  auto t0 = std::chrono::steady_clock::now();
+  publisher.publish(sim);
+  auto t1 = std::chrono::steady_clock::now();
+  std::shared_ptr<const SurfaceSnapshot> snap = publisher.current();
+
+  std::uniform_real_distribution<float> posDist(-0.5f * N * step, 0.5f * N * step);
+  std::vector<float> xs(count), zs(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    xs[i] = posDist(rng);
+    zs[i] = posDist(rng);
+  }
+  std::vector<WaterSample> out(count);
+
+  auto measure = [&](const char *label, auto &&fn) {
+    fn();
+    auto a = std::chrono::steady_clock::now();
+    int reps = 5;
+    for (int r = 0; r < reps; ++r)
+      fn();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - a).count();
+    std::printf("%-22s %10.1f Mrequêtes/s\n", label, reps * count / s * 1e-6);
+  };
+
+  std::printf("grille %dx%d, %zu points, instantané publié en %.2f ms\n", N + 1, N + 1, count,
+              std::chrono::duration<double, std::milli>(t1 - t0).count());
+  measure("scalaire, 1 thread", [&] { snap->sampleScalar(xs.data(), zs.data(), count, out.data()); });
+  measure("SIMD, 1 thread", [&] { snap->sample(xs.data(), zs.data(), count, out.data(), 1); });
+  measure("SIMD, tous les cœurs", [&] { snap->sample(xs.data(), zs.data(), count, out.data(), 0); });
+  return 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+// Lit une carte de hauteur PGM (P2 ou P5, 8 ou 16 bits) et la rééchantillonne
+// bilinéairement sur une grille (size + 1)², valeurs dans [0, 1]
+bool loadHeightmap(const std::string &path, int size, std::vector<float> &out);
+// Même lecture en flux, sans garder l'image ni la grille : visit(y, ligne) pour y = 0..size,
+// chaque ligne de size + 1 valeurs n'étant valable que pendant l'appel
+bool visitHeightmapRows(const std::string &path, int size, const std::function<void(int, const float *)> &visit);
+
+// Profondeur sous le niveau de l'eau (0) d'un fond d'altitude
+// minElevation + heightmap * (maxElevation - minElevation) ; 0 sur la terre
+std::vector<float> depthFromHeightmap(const std::vector<float> &heightmap,
+                                      float minElevation, float maxElevation);
@@ -0,0 +1,42 @@
+#pragma once
+#include "simulation.hpp"
+#include "parallel.hpp"
+#include <cstdint>
+#include <vector>
+
+// Champs dérivés de la surface, calculés après Simulation::update() : normale et
+// écume empaquetées en RGBA demi-flottants, prêtes pour glTexSubImage2D (GL_HALF_FLOAT).
+// Seules les tuiles dont la hauteur a changé (ou qui portent encore de l'écume) sont recalculées.
+class DerivedFields
+{
+public:
+  static const int TILE = 16;
+
+  DerivedFields(int size, float dx, float heightScale = 1.0f);
+
+  // Met à jour les tuiles modifiées ; retourne les lignes [begin, end) à renvoyer au GPU
+  std::pair<int, int> update(const Simulation &sim, float dt);
+
+  const std::vector<uint16_t> &getPacked() const;
+  const std::vector<float> &getFoam() const;
+  int getUpdatedTiles() const;
+
+  // Paramètres de l'écume
+  float divergenceGain = 4.0f, curvatureGain = 2.0f;
+  float divergenceThreshold = 0.05f, curvatureThreshold = 0.05f;
+  float decayRate = 1.5f;   // 1/s
+  float changeEpsilon = 1e-4f;
+
+private:
+  void computeTile(int tx, int ty, const Simulation &sim, float dt);
+
+  int N, tiles;
+  float dx, heightScale;
+  std::vector<float> seen, foam;
+  std::vector<uint16_t> packed;
+  std::vector<uint8_t> changed, dirty, foamy;
+  int updatedTiles = 0;
+  bool first = true;
+  // Créés une fois : update() est appelé à chaque image
+  WorkerPool pool;
+};
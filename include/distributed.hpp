@@ -0,0 +1,89 @@
+#pragma once
+#include "simulation.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Liaison avec le sous-domaine voisin : envoi non bloquant, réception bloquante.
+// complete() termine les envois en cours avant que le tampon ne soit réutilisé.
+class HaloLink
+{
+public:
+  virtual ~HaloLink() = default;
+  virtual void send(const float *data, size_t count) = 0;
+  virtual void recv(float *data, size_t count) = 0;
+  virtual void complete() = 0;
+};
+
+// Socket Unix connectée (socketpair) ; les envois partiels progressent pendant recv()
+class SocketLink : public HaloLink
+{
+public:
+  explicit SocketLink(int fd);
+  ~SocketLink() override;
+
+  void send(const float *data, size_t count) override;
+  void recv(float *data, size_t count) override;
+  void complete() override;
+
+private:
+  bool flush(bool block);
+
+  int fd;
+  std::vector<char> pending;
+  size_t sent = 0;
+};
+
+// Mémoire partagée entre deux processus : un canal par sens, deux emplacements chacun.
+// Un voisin ne peut avoir qu'un échange d'avance puisqu'il attend nos halos à chaque pas.
+class SharedMemoryLink : public HaloLink
+{
+public:
+  // Région partagée (mmap anonyme) à créer avant fork() et à libérer après
+  static void *allocate(size_t capacity);
+  static void release(void *region, size_t capacity);
+  // side = 0 ou 1 : chaque extrémité écrit dans son canal et lit celui de l'autre
+  SharedMemoryLink(void *region, size_t capacity, int side);
+
+  void send(const float *data, size_t count) override;
+  void recv(float *data, size_t count) override;
+  void complete() override;
+
+private:
+  struct Channel
+  {
+    alignas(64) std::atomic<uint64_t> published;
+  };
+  static size_t channelBytes(size_t capacity);
+  float *slot(Channel *c, uint64_t k) const;
+
+  Channel *out, *in;
+  size_t capacity;
+  uint64_t sent = 0, received = 0;
+};
+
+enum class Transport
+{
+  SharedMemory,
+  UnixSocket
+};
+
+struct RowRange
+{
+  int begin, end;
+};
+
+// Découpe les N + 1 lignes de la grille en `parts` bandes contiguës
+std::vector<RowRange> splitRows(int size, int parts);
+
+// Lance un processus par bande (fork) : chacun construit son sous-domaine, le relie
+// à ses voisins et exécute `body`. Retourne la hauteur globale rassemblée, vide en cas d'échec.
+std::vector<float> runDistributed(int size, float dx, float dt, float damping, int parts,
+                                  Transport transport, const std::function<void(Simulation &)> &body);
+// Même exécution sans rassembler la grille : aucun processus n'alloue (N + 1)² valeurs, chaque
+// `body` lit sa bathymétrie (setBathymetry par lignes, loadBathymetry) et écrit ses propres
+// lignes. Retourne false si un sous-domaine échoue.
+bool runDistributedBands(int size, float dx, float dt, float damping, int parts, Transport transport,
+                         const std::function<void(Simulation &)> &body);
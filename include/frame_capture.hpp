@@ -0,0 +1,84 @@
+#pragma once
+#include <GL/glew.h>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class CaptureFormat
+{
+  Y4M,  // fichier .y4m
+  Pipe, // flux Y4M envoyé sur l'entrée standard d'un encodeur ("|ffmpeg -i - out.mp4") ;
+        // l'application doit ignorer SIGPIPE pour survivre à l'arrêt de l'encodeur
+  PNG   // séquence d'images ("frames/img_%05d.png")
+};
+
+struct CaptureStats
+{
+  uint64_t captured = 0; // images relues depuis le GPU
+  uint64_t written = 0;  // images encodées et écrites
+  uint64_t dropped = 0;  // file pleine : image abandonnée
+  uint64_t skipped = 0;  // taille du framebuffer différente de celle de la vidéo
+};
+
+// Capture asynchrone du framebuffer : glReadPixels vers un anneau de PBO,
+// relecture quelques images plus tard une fois la fence signalée, puis
+// encodage et écriture sur des threads de travail.
+class FrameCapture
+{
+public:
+  FrameCapture(int width, int height, const std::string &target, int fps = 60,
+               int ringSize = 3, int queueDepth = 8, int workers = 2);
+  ~FrameCapture();
+
+  bool isOpen() const;
+  CaptureFormat getFormat() const;
+
+  // À appeler après le rendu et avant glutSwapBuffers() (lit GL_BACK).
+  void capture();
+  // Vide l'anneau de PBO puis attend les threads ; le contexte GL doit être actif.
+  void finish();
+
+  CaptureStats getStats() const;
+
+private:
+  struct Frame
+  {
+    uint64_t seq = 0;
+    std::vector<uint8_t> rgba;
+  };
+
+  void collect(int slot);
+  void enqueue(std::vector<uint8_t> &&rgba);
+  void workerLoop();
+  void encodeY4M(const Frame &frame, std::vector<uint8_t> &out) const;
+  void encodePNG(const Frame &frame, std::vector<uint8_t> &out) const;
+
+  int width, height, fps;
+  CaptureFormat format;
+  std::string target;
+  // Séquence PNG : nom = préfixe + numéro complété à pngDigits + suffixe
+  std::string pngPrefix, pngSuffix;
+  int pngDigits = 0;
+  char pngPad = '0';
+  FILE *out = nullptr;
+  bool finished = false;
+
+  std::vector<GLuint> pbos;
+  std::vector<GLsync> fences;
+  int head = 0;
+
+  size_t queueDepth;
+  std::deque<Frame> queue;
+  std::vector<std::vector<uint8_t>> pool;
+  uint64_t nextSeq = 0, nextWrite = 0;
+  bool stopping = false;
+  CaptureStats stats;
+  mutable std::mutex mutex;
+  std::condition_variable queueCv, writeCv;
+  std::vector<std::thread> workers;
+};
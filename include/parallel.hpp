@@ -0,0 +1,119 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Découpe [begin, end) en blocs contigus d'au moins minChunk éléments et appelle
+// f(b, e) sur chacun, en parallèle ; threads = 0 : un par cœur
+template <class F>
+void parallelFor(size_t begin, size_t end, size_t minChunk, F &&f, int threads = 0)
+{
+  size_t n = end > begin ? end - begin : 0;
+  if (threads <= 0)
+    threads = int(std::max(1u, std::thread::hardware_concurrency()));
+  size_t parts = std::min<size_t>(size_t(threads), std::max<size_t>(1, n / std::max<size_t>(1, minChunk)));
+  if (parts <= 1)
+  {
+    if (n > 0)
+      f(begin, end);
+    return;
+  }
+
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < parts; ++t)
+    pool.emplace_back([&f, begin, n, t, parts] { f(begin + n * t / parts, begin + n * (t + 1) / parts); });
+  f(begin, begin + n / parts);
+  for (auto &th : pool)
+    th.join();
+}
+
+// Threads persistants pour les passes répétées à chaque image : run() découpe comme
+// parallelFor, mais réveille des threads existants au lieu d'en créer
+class WorkerPool
+{
+public:
+  // threads = 0 : un par cœur ; l'appelant de run() compte pour un
+  explicit WorkerPool(int threads = 0)
+  {
+    if (threads <= 0)
+      threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    for (int t = 1; t < threads; ++t)
+      workers.emplace_back([this, t] { work(size_t(t)); });
+  }
+
+  ~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m);
+      stop = true;
+    }
+    wake.notify_all();
+    for (auto &th : workers)
+      th.join();
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  template <class F>
+  void run(size_t begin, size_t end, size_t minChunk, F &&f)
+  {
+    size_t n = end > begin ? end - begin : 0;
+    size_t parts = std::min(workers.size() + 1, std::max<size_t>(1, n / std::max<size_t>(1, minChunk)));
+    if (parts <= 1)
+    {
+      if (n > 0)
+        f(begin, end);
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m);
+      job = [&f](size_t b, size_t e) { f(b, e); };
+      jobBegin = begin;
+      jobSize = n;
+      jobParts = parts;
+      pending = parts - 1;
+      ++generation;
+    }
+    wake.notify_all();
+    f(begin, begin + n / parts);
+    std::unique_lock<std::mutex> lock(m);
+    done.wait(lock, [this] { return pending == 0; });
+  }
+
+private:
+  void work(size_t t)
+  {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(m);
+    for (;;)
+    {
+      wake.wait(lock, [&] { return stop || generation != seen; });
+      if (stop)
+        return;
+      seen = generation;
+      if (t >= jobParts)
+        continue;
+      // Le travail en cours ne change pas avant que pending ne retombe à 0
+      lock.unlock();
+      job(jobBegin + jobSize * t / jobParts, jobBegin + jobSize * (t + 1) / jobParts);
+      lock.lock();
+      if (--pending == 0)
+        done.notify_one();
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::mutex m;
+  std::condition_variable wake, done;
+  std::function<void(size_t, size_t)> job;
+  size_t jobBegin = 0, jobSize = 0, jobParts = 0, pending = 0;
+  uint64_t generation = 0;
+  bool stop = false;
+};
@@ -1,22 +1,108 @@
 #pragma once
+#include <string>
 #include <vector>
 
+class HaloLink;
+
+enum class Integrator
+{
+  ForwardCentered,   // schéma d'origine : Euler explicite, différences centrées, grille collocalisée
+  StaggeredLeapfrog, // grille C d'Arakawa, avant-arrière (u, v aux faces)
+  RK3                // Runge-Kutta SSP d'ordre 3, différences centrées
+};
+
 class Simulation
 {
 public:
   Simulation(int size, float dx, float dt, float damping = 0.99f);
+  // Sous-domaine : lignes [rowBegin, rowEnd) de la grille globale, plus une ligne de halo de chaque côté
+  Simulation(int size, int rowBegin, int rowEnd, float dx, float dt, float damping = 0.99f);
 
   void update();
+  // Avance de `duration` secondes en sous-pas égaux respectant la CFL ; retourne le nombre de pas
+  int advance(float duration);
 
   void addDrop(int x, int y, float amplitude, int radius = 3);
 
+  void setIntegrator(Integrator scheme);
+  Integrator getIntegrator() const;
+  void setCfl(float cfl);
+  float stableTimeStep() const;
+  // Sous-pas par seconde simulée depuis le dernier setIntegrator()
+  float getStepsPerSimSecond() const;
+
+  // Profondeur au repos de chaque cellule de la grille globale ((N + 1)², 0 = terre).
+  // Avec une bathymétrie, u et v portent le débit (profondeur × vitesse).
+  void setBathymetry(const std::vector<float> &depth);
+  // Lignes stockées seulement (getRowOffset() et suivantes, halos compris, getHeight().size() valeurs),
+  // pour ne pas charger la grille globale dans chaque sous-domaine. globalMaxDepth, le maximum
+  // sur toute la grille, doit être le même pour toutes les bandes : il fixe le sous-pas.
+  void setBathymetry(const std::vector<float> &localDepth, float globalMaxDepth);
+  // Carte de hauteur PGM : niveaux de gris -> altitude du fond dans [minElevation, maxElevation],
+  // lue en flux ; un sous-domaine ne garde que ses lignes
+  bool loadBathymetry(const std::string &path, float minElevation, float maxElevation);
+  const std::vector<float> &getDepth() const;
+  // Profondeur qui ramène u, v à des vitesses : aux faces sur la grille C (nulle sur une face
+  // fermée), aux cellules sinon ; vides sans bathymétrie
+  const std::vector<float> &getDepthU() const;
+  const std::vector<float> &getDepthV() const;
+  const std::vector<float> &getWetMask() const;
+
+  // Voisins du sous-domaine (lignes rowBegin - 1 et rowEnd), nullptr en bord de grille
+  void setHaloLinks(HaloLink *below, HaloLink *above);
+
   const std::vector<float> &getHeight() const;
+  const std::vector<float> &getU() const;
+  const std::vector<float> &getV() const;
   std::vector<float> getVelocity() const;
   int getSize() const;
+  float getDx() const;
+  int getRowBegin() const;
+  int getRowEnd() const;
+  // Première ligne globale stockée : la cellule (x, y) est à l'indice (y - offset) * (N + 1) + x
+  int getRowOffset() const;
   std::pair<float, float> getLocalVelocity(int x, int z) const;
 
 private:
+  void step(float dtStep);
+  std::pair<float, float> localVelocity(int i) const;
+  void precomputeCoefficients();
+
+  // Coef : profondeur uniforme ou coefficients précalculés, choisi une fois par pas
+  template <class Coef> void stepWith(float dtStep, float d, Coef c);
+  template <class Coef> void stepForwardCentered(float dtStep, float d, Coef c);
+  template <class Coef> void stepStaggeredLeapfrog(float dtStep, float d, Coef c);
+  template <class Coef> void stepRK3(float dtStep, float d, Coef c);
+  template <class Coef>
+  void rk3Stage(const std::vector<float> &h0, const std::vector<float> &u0, const std::vector<float> &v0,
+                std::vector<float> &hin, std::vector<float> &uin, std::vector<float> &vin,
+                std::vector<float> &hout, std::vector<float> &uout, std::vector<float> &vout,
+                float a, float b, float dtStep, float d, Coef c);
+
+  template <class Coef> void forwardCenteredRows(int y0, int y1, float dtStep, float d, Coef c);
+  template <class Coef> void leapfrogVelocityRows(int y0, int y1, float dtStep, float d, Coef c);
+  template <class Coef> void leapfrogHeightRows(int y0, int y1, float dtStep, Coef c);
+  template <class Coef>
+  void rk3Rows(int y0, int y1, const std::vector<float> &h0, const std::vector<float> &u0, const std::vector<float> &v0,
+               const std::vector<float> &hin, const std::vector<float> &uin, const std::vector<float> &vin,
+               std::vector<float> &hout, std::vector<float> &uout, std::vector<float> &vout,
+               float a, float b, float dtStep, float d, Coef c);
+
+  void beginExchange(std::vector<float> &a, std::vector<float> &b, std::vector<float> &c);
+  void finishExchange(std::vector<float> &a, std::vector<float> &b, std::vector<float> &c);
+
   int N;
+  int rowBegin, rowEnd, row0;
   float dx, dt, g = 9.81f, damping;
+  float maxDepth = 1.0f, cfl = 0.9f;
+  Integrator scheme = Integrator::ForwardCentered;
+  double simTime = 0.0;
+  long long steps = 0;
   std::vector<float> h, u, v, h_new, u_new, v_new;
+  std::vector<float> h_tmp, u_tmp, v_tmp;
+  // Bathymétrie (vides si profondeur uniforme) : profondeur, masque mouillé, coefficients de u et v,
+  // faces ouvertes (deux cellules mouillées) entre x et x + 1, y et y + 1
+  std::vector<float> depth, wet, coefU, coefV, openX, openY;
+  HaloLink *below = nullptr, *above = nullptr;
+  std::vector<float> haloBuf;
 };
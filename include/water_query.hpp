@@ -0,0 +1,52 @@
+#pragma once
+#include "simulation.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+struct WaterSample
+{
+  float height;
+  float slopeX, slopeZ; // dh/dx, dh/dz
+  float velX, velZ;
+};
+
+// Copie immuable de la surface, interrogeable depuis plusieurs threads.
+// Les positions sont en coordonnées monde, centrées comme la grille de rendu.
+class SurfaceSnapshot
+{
+public:
+  explicit SurfaceSnapshot(const Simulation &sim);
+
+  WaterSample sample(float x, float z) const;
+  // Interpolation bilinéaire de `count` points ; threads = 0 : un par cœur
+  void sample(const float *x, const float *z, size_t count, WaterSample *out, int threads = 0) const;
+  // Chemin scalaire seul, pour comparaison
+  void sampleScalar(const float *x, const float *z, size_t count, WaterSample *out) const;
+
+private:
+  void sampleBatch(const float *x, const float *z, size_t count, WaterSample *out) const;
+  void sampleAVX2(const float *x, const float *z, size_t count, WaterSample *out) const;
+
+  int N, row0, rowLast;
+  float dx, invDx;
+  float uShift, vShift; // u, v décalés d'une demi-maille sur la grille C
+  std::vector<float> h, u, v;
+};
+
+// Lecture directe des champs de la simulation, sans copie, valable jusqu'au prochain pas :
+// pour quelques points par image sur le thread du solveur
+WaterSample sampleSurface(const Simulation &sim, float x, float z);
+void sampleSurface(const Simulation &sim, const float *x, const float *z, size_t count, WaterSample *out);
+
+// Le solveur publie un instantané après chaque pas ; les lecteurs conservent le leur
+// sans jamais bloquer update()
+class SurfacePublisher
+{
+public:
+  void publish(const Simulation &sim);
+  std::shared_ptr<const SurfaceSnapshot> current() const;
+
+private:
+  std::shared_ptr<const SurfaceSnapshot> snapshot;
+};
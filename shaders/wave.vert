@@ -7,7 +7,7 @@ uniform mat4 view;
 uniform mat4 projection;
 
 uniform sampler2D heightMap;
-uniform sampler2D foamMap;
+uniform sampler2D surfaceMap; // rgb : normale, a : ecume
 uniform int gridSize;
 uniform float step;
 uniform float heightScale;
@@ -23,16 +23,12 @@ void main() {
     float h = texture(heightMap, UV).r;
     vec3 pos = vec3(aPos.x, h * heightScale, aPos.z);
 
-    float du = 1.0 / float(gridSize);
-    float hl = texture(heightMap, UV + vec2(-du, 0)).r;
-    float hr = texture(heightMap, UV + vec2( du, 0)).r;
-    float hd = texture(heightMap, UV + vec2(0, -du)).r;
-    float hu = texture(heightMap, UV + vec2(0,  du)).r;
-    vec3 n = normalize(vec3((hl - hr) * heightScale, 2.0 * step, (hd - hu) * heightScale));
+    vec4 surface = texture(surfaceMap, UV);
+    vec3 n = normalize(surface.xyz);
 
     FragPos = vec3(model * vec4(pos, 1.0));
     Normal = mat3(transpose(inverse(model))) * n;
-    FoamIntensity = texture(foamMap, UV).r;
+    FoamIntensity = surface.a;
 
     gl_Position = projection * view * model * vec4(pos, 1.0);
 }
\ No newline at end of file
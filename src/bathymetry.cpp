@@ -0,0 +1,120 @@
+#include "bathymetry.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+
+static bool readToken(std::istream &in, int &value)
+{
+  // Les commentaires '#' vont jusqu'à la fin de la ligne
+  while (in)
+  {
+    int c = in.peek();
+    if (c == '#')
+      in.ignore(1 << 20, '\n');
+    else if (std::isspace(c))
+      in.get();
+    else
+      break;
+  }
+  return bool(in >> value);
+}
+
+bool visitHeightmapRows(const std::string &path, int size, const std::function<void(int, const float *)> &visit)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    std::cerr << "Bathymétrie : impossible d'ouvrir " << path << std::endl;
+    return false;
+  }
+  char magic[2] = {};
+  file.read(magic, 2);
+  int w = 0, hgt = 0, maxval = 0;
+  if (magic[0] != 'P' || (magic[1] != '2' && magic[1] != '5') ||
+      !readToken(file, w) || !readToken(file, hgt) || !readToken(file, maxval) ||
+      w < 1 || hgt < 1 || maxval < 1 || maxval > 65535)
+  {
+    std::cerr << "Bathymétrie : " << path << " n'est pas un PGM valide" << std::endl;
+    return false;
+  }
+  bool binary = magic[1] == '5';
+  int bytes = maxval < 256 ? 1 : 2;
+  if (binary)
+    file.get(); // un seul blanc après maxval
+
+  // Deux lignes de l'image à la fois : prev = loaded - 1, cur = loaded
+  std::vector<float> prev(w), cur(w);
+  std::vector<unsigned char> raw(size_t(w) * bytes);
+  int loaded = -1;
+  auto readRow = [&] {
+    std::swap(prev, cur);
+    if (binary)
+    {
+      if (!file.read(reinterpret_cast<char *>(raw.data()), raw.size()))
+        return false;
+      for (int x = 0; x < w; ++x)
+        cur[x] = bytes == 1 ? raw[x] : float((raw[2 * x] << 8) | raw[2 * x + 1]);
+    }
+    else
+    {
+      for (float &p : cur)
+      {
+        int value;
+        if (!readToken(file, value))
+          return false;
+        p = float(value);
+      }
+    }
+    ++loaded;
+    return true;
+  };
+
+  std::vector<float> row(size + 1);
+  for (int y = 0; y <= size; ++y)
+  {
+    float sy = size > 0 ? float(y) * (hgt - 1) / size : 0.0f;
+    int y0 = std::min(int(sy), hgt - 1), y1 = std::min(y0 + 1, hgt - 1);
+    float fy = sy - y0;
+    while (loaded < y1)
+    {
+      if (!readRow())
+      {
+        std::cerr << "Bathymétrie : " << path << " tronqué" << std::endl;
+        return false;
+      }
+    }
+    const float *r0 = y0 == loaded ? cur.data() : prev.data(), *r1 = cur.data();
+    for (int x = 0; x <= size; ++x)
+    {
+      float sx = size > 0 ? float(x) * (w - 1) / size : 0.0f;
+      int x0 = std::min(int(sx), w - 1), x1 = std::min(x0 + 1, w - 1);
+      float fx = sx - x0;
+      float top = r0[x0] + fx * (r0[x1] - r0[x0]);
+      float bot = r1[x0] + fx * (r1[x1] - r1[x0]);
+      row[x] = (top + fy * (bot - top)) / maxval;
+    }
+    visit(y, row.data());
+  }
+  return true;
+}
+
+bool loadHeightmap(const std::string &path, int size, std::vector<float> &out)
+{
+  std::vector<float> grid(size_t(size + 1) * (size + 1));
+  if (!visitHeightmapRows(path, size, [&](int y, const float *row) {
+        std::copy(row, row + size + 1, grid.begin() + size_t(y) * (size + 1));
+      }))
+    return false;
+  out = std::move(grid);
+  return true;
+}
+
+std::vector<float> depthFromHeightmap(const std::vector<float> &heightmap,
+                                      float minElevation, float maxElevation)
+{
+  std::vector<float> depth(heightmap.size());
+  for (size_t i = 0; i < heightmap.size(); ++i)
+    depth[i] = std::max(0.0f, -(minElevation + heightmap[i] * (maxElevation - minElevation)));
+  return depth;
+}
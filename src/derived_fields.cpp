@@ -0,0 +1,141 @@
+#include "derived_fields.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Demi-flottant IEEE, arrondi au plus proche ; les sous-normaux sont mis à zéro
+static uint16_t toHalf(float f)
+{
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  uint32_t sign = (x >> 16) & 0x8000u;
+  int exp = int((x >> 23) & 0xFF) - 127 + 15;
+  uint32_t mant = x & 0x7FFFFFu;
+  if (exp <= 0)
+    return uint16_t(sign);
+  if (exp >= 31)
+    return uint16_t(sign | 0x7C00u);
+  return uint16_t(sign | ((uint32_t(exp) << 10) + ((mant + 0x1000u) >> 13)));
+}
+
+DerivedFields::DerivedFields(int size, float dx, float heightScale)
+    : N(size), tiles((size + TILE) / TILE), dx(dx), heightScale(heightScale),
+      seen((size + 1) * (size + 1), 0.0f),
+      foam((size + 1) * (size + 1), 0.0f),
+      packed(4 * (size + 1) * (size + 1), 0),
+      changed(tiles * tiles, 0), dirty(tiles * tiles, 0), foamy(tiles * tiles, 0),
+      pool(std::min(tiles, int(std::max(1u, std::thread::hardware_concurrency()))))
+{
+}
+
+const std::vector<uint16_t> &DerivedFields::getPacked() const { return packed; }
+const std::vector<float> &DerivedFields::getFoam() const { return foam; }
+int DerivedFields::getUpdatedTiles() const { return updatedTiles; }
+
+std::pair<int, int> DerivedFields::update(const Simulation &sim, float dt)
+{
+  if (sim.getSize() != N || sim.getRowOffset() != 0)
+    return {0, 0};
+  const std::vector<float> &h = sim.getHeight();
+  int stride = N + 1;
+
+  // Tuiles dont la hauteur a bougé depuis leur dernier calcul
+  pool.run(0, tiles, 4, [&](size_t b, size_t e) {
+    for (int ty = int(b); ty < int(e); ++ty)
+    {
+      for (int tx = 0; tx < tiles; ++tx)
+      {
+        float delta = 0.0f;
+        for (int y = ty * TILE; y < std::min(stride, (ty + 1) * TILE); ++y)
+          for (int x = tx * TILE; x < std::min(stride, (tx + 1) * TILE); ++x)
+            delta = std::max(delta, std::fabs(h[y * stride + x] - seen[y * stride + x]));
+        changed[ty * tiles + tx] = first || delta > changeEpsilon;
+      }
+    }
+  });
+
+  // Les bords d'une tuile dépendent des voisines : on dilate d'une tuile
+  int yMin = stride, yMax = 0;
+  updatedTiles = 0;
+  for (int ty = 0; ty < tiles; ++ty)
+  {
+    for (int tx = 0; tx < tiles; ++tx)
+    {
+      bool d = foamy[ty * tiles + tx];
+      for (int j = std::max(0, ty - 1); j <= std::min(tiles - 1, ty + 1) && !d; ++j)
+        for (int i = std::max(0, tx - 1); i <= std::min(tiles - 1, tx + 1) && !d; ++i)
+          d = changed[j * tiles + i];
+      dirty[ty * tiles + tx] = d;
+      if (d)
+      {
+        ++updatedTiles;
+        yMin = std::min(yMin, ty * TILE);
+        yMax = std::max(yMax, std::min(stride, (ty + 1) * TILE));
+      }
+    }
+  }
+
+  pool.run(0, tiles, 1, [&](size_t b, size_t e) {
+    for (int ty = int(b); ty < int(e); ++ty)
+      for (int tx = 0; tx < tiles; ++tx)
+        if (dirty[ty * tiles + tx])
+          computeTile(tx, ty, sim, dt);
+  });
+  first = false;
+
+  if (yMin >= yMax)
+    return {0, 0};
+  return {yMin, yMax};
+}
+
+void DerivedFields::computeTile(int tx, int ty, const Simulation &sim, float dt)
+{
+  const std::vector<float> &h = sim.getHeight();
+  const std::vector<float> &u = sim.getU();
+  const std::vector<float> &v = sim.getV();
+  bool staggered = sim.getIntegrator() == Integrator::StaggeredLeapfrog;
+  int stride = N + 1;
+  float invDx = 1.0f / dx;
+  float decay = std::exp(-decayRate * dt);
+  float maxFoam = 0.0f;
+
+  int y1 = std::min(stride, (ty + 1) * TILE), x1 = std::min(stride, (tx + 1) * TILE);
+  for (int y = ty * TILE; y < y1; ++y)
+  {
+    int yl = std::max(y - 1, 0), yr = std::min(y + 1, N);
+    for (int x = tx * TILE; x < x1; ++x)
+    {
+      int xl = std::max(x - 1, 0), xr = std::min(x + 1, N);
+      int i = y * stride + x;
+      int il = y * stride + xl, ir = y * stride + xr;
+      int id = yl * stride + x, iu = yr * stride + x;
+
+      // Pente et normale (différences centrées, décentrées au bord)
+      float dhdx = (h[ir] - h[il]) * invDx / float(xr - xl);
+      float dhdz = (h[iu] - h[id]) * invDx / float(yr - yl);
+      float nx = -dhdx * heightScale, nz = -dhdz * heightScale;
+      float inv = 1.0f / std::sqrt(nx * nx + 1.0f + nz * nz);
+
+      // Convergence de l'écoulement et crêtes (laplacien négatif) génèrent l'écume
+      float div = staggered
+                      ? (u[i] - u[std::max(i - 1, y * stride)] + v[i] - v[std::max(i - stride, x)]) * invDx
+                      : (u[ir] - u[il]) * invDx / float(xr - xl) + (v[iu] - v[id]) * invDx / float(yr - yl);
+      float lap = (h[il] + h[ir] + h[id] + h[iu] - 4.0f * h[i]) * invDx * invDx;
+      float source = divergenceGain * std::max(0.0f, -div - divergenceThreshold) +
+                     curvatureGain * std::max(0.0f, -lap * heightScale - curvatureThreshold);
+      float f = std::min(1.0f, foam[i] * decay + dt * source);
+      if (f < 1e-3f)
+        f = 0.0f;
+      foam[i] = f;
+      maxFoam = std::max(maxFoam, f);
+
+      uint16_t *p = &packed[4 * size_t(i)];
+      p[0] = toHalf(nx * inv);
+      p[1] = toHalf(inv);
+      p[2] = toHalf(nz * inv);
+      p[3] = toHalf(f);
+      seen[i] = h[i];
+    }
+  }
+  foamy[ty * tiles + tx] = maxFoam > 0.0f;
+}
@@ -0,0 +1,286 @@
+#include "distributed.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+SocketLink::SocketLink(int fd) : fd(fd) {}
+
+SocketLink::~SocketLink()
+{
+  close(fd);
+}
+
+bool SocketLink::flush(bool block)
+{
+  while (sent < pending.size())
+  {
+    ssize_t n = ::send(fd, pending.data() + sent, pending.size() - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n > 0)
+    {
+      sent += size_t(n);
+      continue;
+    }
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      throw std::runtime_error(std::string("halo send: ") + std::strerror(errno));
+    if (!block)
+      return false;
+    pollfd p{fd, POLLOUT, 0};
+    poll(&p, 1, -1);
+  }
+  return true;
+}
+
+void SocketLink::send(const float *data, size_t count)
+{
+  flush(true);
+  const char *bytes = reinterpret_cast<const char *>(data);
+  pending.assign(bytes, bytes + count * sizeof(float));
+  sent = 0;
+  flush(false);
+}
+
+void SocketLink::recv(float *data, size_t count)
+{
+  char *dst = reinterpret_cast<char *>(data);
+  size_t need = count * sizeof(float), got = 0;
+  while (got < need)
+  {
+    // On continue d'écrire pendant l'attente : les deux voisins peuvent envoyer en même temps
+    pollfd p{fd, short(POLLIN | (sent < pending.size() ? POLLOUT : 0)), 0};
+    if (poll(&p, 1, -1) < 0 && errno != EINTR)
+      throw std::runtime_error(std::string("halo poll: ") + std::strerror(errno));
+    if (p.revents & POLLOUT)
+      flush(false);
+    if (p.revents & (POLLIN | POLLHUP | POLLERR))
+    {
+      ssize_t n = ::recv(fd, dst + got, need - got, MSG_DONTWAIT);
+      if (n > 0)
+        got += size_t(n);
+      else if (n == 0)
+        throw std::runtime_error("halo recv: voisin déconnecté");
+      else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        throw std::runtime_error(std::string("halo recv: ") + std::strerror(errno));
+    }
+  }
+}
+
+void SocketLink::complete()
+{
+  flush(true);
+}
+
+size_t SharedMemoryLink::channelBytes(size_t capacity)
+{
+  size_t bytes = sizeof(Channel) + 2 * capacity * sizeof(float);
+  return (bytes + 63) / 64 * 64;
+}
+
+void *SharedMemoryLink::allocate(size_t capacity)
+{
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "compteur partagé entre processus");
+  size_t bytes = 2 * channelBytes(capacity);
+  void *region = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (region == MAP_FAILED)
+    return nullptr;
+  char *base = static_cast<char *>(region);
+  new (base) Channel{{0}};
+  new (base + channelBytes(capacity)) Channel{{0}};
+  return region;
+}
+
+void SharedMemoryLink::release(void *region, size_t capacity)
+{
+  if (region)
+    munmap(region, 2 * channelBytes(capacity));
+}
+
+SharedMemoryLink::SharedMemoryLink(void *region, size_t capacity, int side)
+    : capacity(capacity)
+{
+  char *base = static_cast<char *>(region);
+  Channel *c0 = reinterpret_cast<Channel *>(base);
+  Channel *c1 = reinterpret_cast<Channel *>(base + channelBytes(capacity));
+  out = side == 0 ? c0 : c1;
+  in = side == 0 ? c1 : c0;
+}
+
+float *SharedMemoryLink::slot(Channel *c, uint64_t k) const
+{
+  return reinterpret_cast<float *>(c + 1) + (k & 1) * capacity;
+}
+
+void SharedMemoryLink::send(const float *data, size_t count)
+{
+  std::memcpy(slot(out, sent), data, count * sizeof(float));
+  out->published.store(++sent, std::memory_order_release);
+}
+
+void SharedMemoryLink::recv(float *data, size_t count)
+{
+  for (int spin = 0; in->published.load(std::memory_order_acquire) <= received; ++spin)
+  {
+    if (spin > 1000)
+      std::this_thread::yield();
+  }
+  std::memcpy(data, slot(in, received), count * sizeof(float));
+  ++received;
+}
+
+void SharedMemoryLink::complete()
+{
+}
+
+std::vector<RowRange> splitRows(int size, int parts)
+{
+  int rows = size + 1;
+  parts = std::clamp(parts, 1, rows);
+  std::vector<RowRange> ranges(parts);
+  for (int r = 0; r < parts; ++r)
+    ranges[r] = {r * rows / parts, (r + 1) * rows / parts};
+  return ranges;
+}
+
+std::vector<float> runDistributed(int size, float dx, float dt, float damping, int parts,
+                                  Transport transport, const std::function<void(Simulation &)> &body)
+{
+  size_t stride = size + 1;
+  size_t outBytes = stride * stride * sizeof(float);
+  float *gathered = static_cast<float *>(
+      mmap(nullptr, outBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+  if (gathered == MAP_FAILED)
+  {
+    std::cerr << "runDistributed: mmap impossible" << std::endl;
+    return {};
+  }
+
+  // Chaque rang recopie ses lignes possédées dans la région partagée
+  bool ok = runDistributedBands(size, dx, dt, damping, parts, transport, [&](Simulation &sim) {
+    body(sim);
+    const std::vector<float> &h = sim.getHeight();
+    int offset = sim.getRowOffset();
+    for (int y = sim.getRowBegin(); y < sim.getRowEnd(); ++y)
+      std::copy_n(h.begin() + (y - offset) * stride, stride, gathered + y * stride);
+  });
+
+  std::vector<float> result;
+  if (ok)
+    result.assign(gathered, gathered + stride * stride);
+  munmap(gathered, outBytes);
+  return result;
+}
+
+bool runDistributedBands(int size, float dx, float dt, float damping, int parts, Transport transport,
+                         const std::function<void(Simulation &)> &body)
+{
+  std::vector<RowRange> ranges = splitRows(size, parts);
+  parts = int(ranges.size());
+  size_t stride = size + 1;
+  size_t capacity = 3 * stride;
+
+  // Liaison p entre les rangs p (extrémité 0) et p + 1 (extrémité 1)
+  std::vector<int> fds(2 * (parts - 1), -1);
+  std::vector<void *> regions(parts - 1, nullptr);
+  bool ok = true;
+  for (int p = 0; p + 1 < parts && ok; ++p)
+  {
+    if (transport == Transport::UnixSocket)
+      ok = socketpair(AF_UNIX, SOCK_STREAM, 0, &fds[2 * p]) == 0;
+    else
+      ok = (regions[p] = SharedMemoryLink::allocate(capacity)) != nullptr;
+  }
+
+  // Sinon les tampons de sortie seraient dupliqués dans chaque processus
+  std::cout.flush();
+  std::fflush(nullptr);
+
+  std::vector<pid_t> pids;
+  for (int r = 0; r < parts && ok; ++r)
+  {
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+      ok = false;
+      break;
+    }
+    if (pid > 0)
+    {
+      pids.push_back(pid);
+      continue;
+    }
+
+    int status = 0;
+    try
+    {
+      std::unique_ptr<HaloLink> lo, hi;
+      for (int p = 0; p + 1 < parts; ++p)
+      {
+        if (transport == Transport::UnixSocket)
+        {
+          if (p != r)
+            close(fds[2 * p]);
+          if (p != r - 1)
+            close(fds[2 * p + 1]);
+        }
+      }
+      if (r > 0)
+        lo = transport == Transport::UnixSocket
+                 ? std::unique_ptr<HaloLink>(new SocketLink(fds[2 * (r - 1) + 1]))
+                 : std::unique_ptr<HaloLink>(new SharedMemoryLink(regions[r - 1], capacity, 1));
+      if (r + 1 < parts)
+        hi = transport == Transport::UnixSocket
+                 ? std::unique_ptr<HaloLink>(new SocketLink(fds[2 * r]))
+                 : std::unique_ptr<HaloLink>(new SharedMemoryLink(regions[r], capacity, 0));
+
+      Simulation sim(size, ranges[r].begin, ranges[r].end, dx, dt, damping);
+      sim.setHaloLinks(lo.get(), hi.get());
+      body(sim);
+    }
+    catch (const std::exception &e)
+    {
+      std::cerr << "Sous-domaine " << r << " : " << e.what() << std::endl;
+      status = 1;
+    }
+    std::cout.flush();
+    _exit(status);
+  }
+
+  for (int fd : fds)
+    if (fd >= 0)
+      close(fd);
+
+  // Un rang en échec bloquerait ses voisins : on arrête les autres
+  if (!ok)
+    for (pid_t pid : pids)
+      kill(pid, SIGTERM);
+  for (size_t done = 0; done < pids.size(); ++done)
+  {
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0)
+      break;
+    if ((!WIFEXITED(status) || WEXITSTATUS(status) != 0) && ok)
+    {
+      for (pid_t other : pids)
+        kill(other, SIGTERM);
+      ok = false;
+    }
+  }
+
+  if (!ok)
+    std::cerr << "runDistributed: échec d'un sous-domaine" << std::endl;
+  for (void *region : regions)
+    SharedMemoryLink::release(region, capacity);
+  return ok;
+}
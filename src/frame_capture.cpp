@@ -0,0 +1,431 @@
+#include "frame_capture.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+static bool endsWith(const std::string &s, const std::string &suffix)
+{
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Motif de séquence : exactement une conversion %d, %5d ou %05d, "%%" pour un % littéral.
+// Le nom est construit sans snprintf : la cible vient de la ligne de commande.
+static bool parsePattern(const std::string &pattern, std::string &prefix, std::string &suffix,
+                         int &digits, char &pad)
+{
+  std::string *part = &prefix;
+  bool found = false;
+  for (size_t i = 0; i < pattern.size(); ++i)
+  {
+    if (pattern[i] != '%')
+    {
+      *part += pattern[i];
+      continue;
+    }
+    if (i + 1 < pattern.size() && pattern[i + 1] == '%')
+    {
+      *part += '%';
+      ++i;
+      continue;
+    }
+    if (found)
+      return false;
+    size_t j = i + 1;
+    pad = j < pattern.size() && pattern[j] == '0' ? '0' : ' ';
+    digits = 0;
+    while (j < pattern.size() && std::isdigit((unsigned char)pattern[j]) && digits < 100)
+      digits = digits * 10 + (pattern[j++] - '0');
+    if (j >= pattern.size() || pattern[j] != 'd')
+      return false;
+    found = true;
+    part = &suffix;
+    i = j;
+  }
+  return found;
+}
+
+FrameCapture::FrameCapture(int width, int height, const std::string &target,
+                           int fps, int ringSize, int queueDepth, int workerCount)
+    : width(width), height(height), fps(fps), target(target),
+      queueDepth(std::max(1, queueDepth))
+{
+  if (!target.empty() && target[0] == '|')
+    format = CaptureFormat::Pipe;
+  else if (endsWith(target, ".png") || target.find('%') != std::string::npos)
+    format = CaptureFormat::PNG;
+  else
+    format = CaptureFormat::Y4M;
+
+  if (format == CaptureFormat::PNG)
+  {
+    // "out.png" -> "out_00000.png", "dir/%04d.png" est utilisé tel quel
+    if (this->target.find('%') == std::string::npos)
+      this->target.insert(this->target.size() - 4, "_%05d");
+    if (!parsePattern(this->target, pngPrefix, pngSuffix, pngDigits, pngPad))
+    {
+      std::cerr << "Capture: " << target << " doit contenir un seul %d (ou %05d)" << std::endl;
+      finished = true;
+      return;
+    }
+  }
+  else
+  {
+    // 4:2:0 : dimensions paires
+    this->width &= ~1;
+    this->height &= ~1;
+    if (format == CaptureFormat::Pipe)
+      out = popen(target.c_str() + 1, "w");
+    else
+      out = std::fopen(target.c_str(), "wb");
+    if (!out)
+    {
+      std::cerr << "Capture: impossible d'ouvrir " << target << std::endl;
+      finished = true;
+      return;
+    }
+    std::fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+                 this->width, this->height, fps);
+  }
+
+  size_t bytes = size_t(this->width) * this->height * 4;
+  pbos.resize(std::max(1, ringSize));
+  fences.assign(pbos.size(), nullptr);
+  glGenBuffers(GLsizei(pbos.size()), pbos.data());
+  for (GLuint pbo : pbos)
+  {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  for (int i = 0; i < std::max(1, workerCount); ++i)
+    workers.emplace_back(&FrameCapture::workerLoop, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+  finish();
+}
+
+bool FrameCapture::isOpen() const { return !finished; }
+CaptureFormat FrameCapture::getFormat() const { return format; }
+
+CaptureStats FrameCapture::getStats() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return stats;
+}
+
+void FrameCapture::capture()
+{
+  if (finished)
+    return;
+
+  GLint vp[4];
+  glGetIntegerv(GL_VIEWPORT, vp);
+  if (vp[2] < width || vp[3] < height)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++stats.skipped;
+    return;
+  }
+
+  // Relit dans l'ordre les PBO déjà prêts, sans bloquer le rendu
+  int ring = int(pbos.size());
+  for (int k = 0; k < ring; ++k)
+  {
+    int slot = (head + k) % ring;
+    if (!fences[slot])
+      continue;
+    GLenum st = glClientWaitSync(fences[slot], 0, 0);
+    if (st != GL_ALREADY_SIGNALED && st != GL_CONDITION_SATISFIED)
+      break;
+    collect(slot);
+  }
+  // Anneau plein : on attend la plus ancienne lecture
+  if (fences[head])
+    collect(head);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[head]);
+  glReadBuffer(GL_BACK);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  fences[head] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  head = (head + 1) % ring;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ++stats.captured;
+}
+
+void FrameCapture::collect(int slot)
+{
+  GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+  while (true)
+  {
+    GLenum st = glClientWaitSync(fences[slot], flags, 100000000);
+    if (st != GL_TIMEOUT_EXPIRED)
+      break;
+    flags = 0;
+  }
+  glDeleteSync(fences[slot]);
+  fences[slot] = nullptr;
+
+  std::vector<uint8_t> rgba;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!pool.empty())
+    {
+      rgba = std::move(pool.back());
+      pool.pop_back();
+    }
+  }
+  size_t bytes = size_t(width) * height * 4;
+  rgba.resize(bytes);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+  const void *src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+  if (src)
+  {
+    std::memcpy(rgba.data(), src, bytes);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  if (src)
+    enqueue(std::move(rgba));
+}
+
+void FrameCapture::enqueue(std::vector<uint8_t> &&rgba)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.size() >= queueDepth)
+    {
+      // Les threads ne suivent pas : on perd l'image plutôt que de bloquer le rendu
+      ++stats.dropped;
+      pool.push_back(std::move(rgba));
+      return;
+    }
+    queue.push_back({nextSeq++, std::move(rgba)});
+  }
+  queueCv.notify_one();
+}
+
+void FrameCapture::workerLoop()
+{
+  std::vector<uint8_t> encoded;
+  while (true)
+  {
+    Frame frame;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      queueCv.wait(lock, [&] { return stopping || !queue.empty(); });
+      if (queue.empty())
+        return;
+      frame = std::move(queue.front());
+      queue.pop_front();
+    }
+
+    bool ok;
+    if (format == CaptureFormat::PNG)
+    {
+      encodePNG(frame, encoded);
+      std::string index = std::to_string(frame.seq);
+      if (int(index.size()) < pngDigits)
+        index.insert(0, pngDigits - index.size(), pngPad);
+      FILE *f = std::fopen((pngPrefix + index + pngSuffix).c_str(), "wb");
+      ok = f && std::fwrite(encoded.data(), 1, encoded.size(), f) == encoded.size();
+      if (f)
+        std::fclose(f);
+    }
+    else
+    {
+      encodeY4M(frame, encoded);
+      // Flux séquentiel : l'encodage est parallèle, l'écriture suit l'ordre des images
+      std::unique_lock<std::mutex> lock(mutex);
+      writeCv.wait(lock, [&] { return nextWrite == frame.seq; });
+      lock.unlock();
+      ok = std::fwrite(encoded.data(), 1, encoded.size(), out) == encoded.size();
+      lock.lock();
+      ++nextWrite;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (ok)
+        ++stats.written;
+      pool.push_back(std::move(frame.rgba));
+    }
+    writeCv.notify_all();
+  }
+}
+
+void FrameCapture::encodeY4M(const Frame &frame, std::vector<uint8_t> &dst) const
+{
+  static const char tag[] = "FRAME\n";
+  size_t header = sizeof(tag) - 1;
+  size_t ySize = size_t(width) * height;
+  size_t cSize = ySize / 4;
+  dst.resize(header + ySize + 2 * cSize);
+  std::memcpy(dst.data(), tag, header);
+  uint8_t *Y = dst.data() + header;
+  uint8_t *U = Y + ySize;
+  uint8_t *V = U + cSize;
+
+  // BT.601 pleine échelle ; glReadPixels renvoie les lignes de bas en haut
+  const uint8_t *src = frame.rgba.data();
+  for (int y = 0; y < height; ++y)
+  {
+    const uint8_t *row = src + size_t(height - 1 - y) * width * 4;
+    uint8_t *yRow = Y + size_t(y) * width;
+    for (int x = 0; x < width; ++x)
+    {
+      int r = row[4 * x], g = row[4 * x + 1], b = row[4 * x + 2];
+      yRow[x] = uint8_t((77 * r + 150 * g + 29 * b + 128) >> 8);
+    }
+  }
+  int cw = width / 2;
+  for (int y = 0; y < height / 2; ++y)
+  {
+    const uint8_t *r0 = src + size_t(height - 1 - 2 * y) * width * 4;
+    const uint8_t *r1 = r0 - size_t(width) * 4;
+    for (int x = 0; x < cw; ++x)
+    {
+      const uint8_t *p = r0 + 8 * x, *q = r1 + 8 * x;
+      int r = (p[0] + p[4] + q[0] + q[4] + 2) >> 2;
+      int g = (p[1] + p[5] + q[1] + q[5] + 2) >> 2;
+      int b = (p[2] + p[6] + q[2] + q[6] + 2) >> 2;
+      int cb = 128 + ((-43 * r - 85 * g + 128 * b + 128) >> 8);
+      int cr = 128 + ((128 * r - 107 * g - 21 * b + 128) >> 8);
+      U[size_t(y) * cw + x] = uint8_t(std::clamp(cb, 0, 255));
+      V[size_t(y) * cw + x] = uint8_t(std::clamp(cr, 0, 255));
+    }
+  }
+}
+
+static uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc = 0)
+{
+  static uint32_t table[256] = {};
+  static bool init = [] {
+    for (uint32_t n = 0; n < 256; ++n)
+    {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k)
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      table[n] = c;
+    }
+    return true;
+  }();
+  (void)init;
+  crc = ~crc;
+  for (size_t i = 0; i < len; ++i)
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+static void putU32(std::vector<uint8_t> &v, uint32_t x)
+{
+  v.insert(v.end(), {uint8_t(x >> 24), uint8_t(x >> 16), uint8_t(x >> 8), uint8_t(x)});
+}
+
+static void putChunk(std::vector<uint8_t> &v, const char *type, const uint8_t *data, size_t len)
+{
+  putU32(v, uint32_t(len));
+  size_t start = v.size();
+  v.insert(v.end(), type, type + 4);
+  v.insert(v.end(), data, data + len);
+  putU32(v, crc32(v.data() + start, len + 4));
+}
+
+void FrameCapture::encodePNG(const Frame &frame, std::vector<uint8_t> &dst) const
+{
+  // PNG RGB 8 bits, flux zlib en blocs "stored" : aucun coût de compression
+  // sur les threads, l'encodage en vidéo se fait plutôt avec le mode pipe.
+  size_t rowBytes = size_t(width) * 3 + 1;
+  std::vector<uint8_t> raw(rowBytes * height);
+  for (int y = 0; y < height; ++y)
+  {
+    const uint8_t *row = frame.rgba.data() + size_t(height - 1 - y) * width * 4;
+    uint8_t *o = raw.data() + y * rowBytes;
+    *o++ = 0;
+    for (int x = 0; x < width; ++x)
+    {
+      *o++ = row[4 * x];
+      *o++ = row[4 * x + 1];
+      *o++ = row[4 * x + 2];
+    }
+  }
+
+  std::vector<uint8_t> z;
+  z.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+  z.push_back(0x78);
+  z.push_back(0x01);
+  uint32_t a = 1, b = 0;
+  size_t pos = 0;
+  while (true)
+  {
+    size_t len = std::min<size_t>(65535, raw.size() - pos);
+    bool last = pos + len == raw.size();
+    z.insert(z.end(), {uint8_t(last), uint8_t(len), uint8_t(len >> 8),
+                       uint8_t(~len), uint8_t(~len >> 8)});
+    z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + len);
+    for (size_t i = pos; i < pos + len; ++i)
+    {
+      a = (a + raw[i]) % 65521;
+      b = (b + a) % 65521;
+    }
+    pos += len;
+    if (last)
+      break;
+  }
+  putU32(z, (b << 16) | a);
+
+  static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  dst.assign(sig, sig + 8);
+  std::vector<uint8_t> ihdr;
+  putU32(ihdr, uint32_t(width));
+  putU32(ihdr, uint32_t(height));
+  ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0});
+  putChunk(dst, "IHDR", ihdr.data(), ihdr.size());
+  putChunk(dst, "IDAT", z.data(), z.size());
+  putChunk(dst, "IEND", nullptr, 0);
+}
+
+void FrameCapture::finish()
+{
+  if (finished && workers.empty())
+    return;
+
+  if (!pbos.empty())
+  {
+    for (int k = 0; k < int(pbos.size()); ++k)
+    {
+      int slot = (head + k) % int(pbos.size());
+      if (fences[slot])
+        collect(slot);
+    }
+    glDeleteBuffers(GLsizei(pbos.size()), pbos.data());
+    pbos.clear();
+  }
+  finished = true;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  queueCv.notify_all();
+  for (auto &t : workers)
+    t.join();
+  workers.clear();
+
+  if (out)
+  {
+    if (format == CaptureFormat::Pipe)
+      pclose(out);
+    else
+      std::fclose(out);
+    out = nullptr;
+  }
+}
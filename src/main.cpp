@@ -9,10 +9,19 @@
 #include "grid.hpp"
 #include "simulation.hpp"
 #include "shader_utils.hpp"
+#include "frame_capture.hpp"
+#include "water_query.hpp"
+#include "derived_fields.hpp"
 
 #include <iostream>
+#include <cmath>
 #include <vector>
 #include <algorithm>
+#include <cstdlib>
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <string>
 
 //#define SAVE_RENDER
 
@@ -34,11 +43,12 @@ static const float HEIGHT_SCALE = 1.0f;
 static const float SPHERE_SIZE = 0.2f;
 
 Simulation sim(N, STEP, DT, DAMPING);
+DerivedFields surfaceFields(N, STEP, HEIGHT_SCALE);
 
 GLuint waterProgram = 0, dropProgram = 0, skyProgram = 0, landProgram = 0;
 GLuint waterVAO = 0, waterVBO = 0;
 int waterCount = 0;
-GLuint heightTex = 0, velocityTex = 0;
+GLuint heightTex = 0, surfaceTex = 0;
 
 GLuint sphereVAO = 0, sphereVBO = 0, sphereEBO = 0;
 int sphereCount = 0;
@@ -64,6 +74,15 @@ bool boatMovedByUser = false;
 
 glm::vec2 boatVelocity(0.0f, 0.0f);
 
+#ifdef SAVE_RENDER
+std::string captureTarget = "render.y4m";
+#else
+std::string captureTarget;
+#endif
+int captureFrames = 0;
+std::unique_ptr<FrameCapture> capture;
+std::string bathymetryPath;
+
 // Prototypes des fonctions
 void init_glut(int &argc, char **argv);
 bool init_glew();
@@ -74,12 +93,17 @@ void init_drop_mesh();
 void init_sky();
 void init_land();
 void init_land_mesh(float innerRadius, float outerRadius, int segments = 128);
+void init_capture();
+void stop_capture();
+void parse_args(int argc, char **argv);
+void init_bathymetry();
 void window_resize(int w, int h);
 void display();
 void idle();
 void mouse_button(int button, int state, int x, int y);
 void mouse_move(int x, int y);
 void keyboard(unsigned char key, int x, int y);
+void close_window();
 
 void init_glut(int &argc, char **argv)
 {
@@ -96,6 +120,8 @@ void init_glut(int &argc, char **argv)
   glutMouseFunc(mouse_button);
   glutMotionFunc(mouse_move);
   glutKeyboardFunc(keyboard);
+  glutCloseFunc(close_window);
+  glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
 }
 
 bool init_glew()
@@ -135,9 +161,10 @@ void init_water_mesh_and_texture()
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); TEST_OPENGL_ERROR();
   glBindTexture(GL_TEXTURE_2D, 0); TEST_OPENGL_ERROR();
 
-  glGenTextures(1, &velocityTex); TEST_OPENGL_ERROR();
-  glBindTexture(GL_TEXTURE_2D, velocityTex); TEST_OPENGL_ERROR();
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, N + 1, N + 1, 0, GL_RED, GL_FLOAT, nullptr); TEST_OPENGL_ERROR();
+  // normale (rgb) et écume (a), calculées sur le CPU par DerivedFields
+  glGenTextures(1, &surfaceTex); TEST_OPENGL_ERROR();
+  glBindTexture(GL_TEXTURE_2D, surfaceTex); TEST_OPENGL_ERROR();
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, N + 1, N + 1, 0, GL_RGBA, GL_HALF_FLOAT, nullptr); TEST_OPENGL_ERROR();
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); TEST_OPENGL_ERROR();
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); TEST_OPENGL_ERROR();
   glBindTexture(GL_TEXTURE_2D, 0); TEST_OPENGL_ERROR();
@@ -238,6 +265,60 @@ void init_land_mesh(float innerRadius, float outerRadius, int segments)
     glBindVertexArray(0);
 }
 
+void init_capture()
+{
+  if (captureTarget.empty())
+    return;
+  // Si l'encodeur s'arrête, l'écriture dans le tube échoue (image non comptée)
+  // au lieu de tuer le programme par SIGPIPE
+  if (captureTarget[0] == '|')
+    std::signal(SIGPIPE, SIG_IGN);
+  int ww = glutGet(GLUT_WINDOW_WIDTH), hh = glutGet(GLUT_WINDOW_HEIGHT);
+  capture = std::make_unique<FrameCapture>(ww, hh, captureTarget);
+  if (!capture->isOpen())
+    capture.reset();
+}
+
+void stop_capture()
+{
+  if (!capture || !capture->isOpen())
+    return;
+  capture->finish();
+  CaptureStats st = capture->getStats();
+  std::cout << "Capture : " << st.written << " images écrites, "
+            << st.dropped << " perdues, " << st.skipped << " ignorées (taille)"
+            << std::endl;
+}
+
+void parse_args(int argc, char **argv)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!std::strcmp(argv[i], "--capture") && i + 1 < argc)
+      captureTarget = argv[++i];
+    else if (!std::strcmp(argv[i], "--frames") && i + 1 < argc)
+      captureFrames = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--bathymetry") && i + 1 < argc)
+      bathymetryPath = argv[++i];
+  }
+}
+
+void init_bathymetry()
+{
+  // Carte PGM : noir = fond à -5, blanc = relief à +5
+  if (!bathymetryPath.empty() && sim.loadBathymetry(bathymetryPath, -5.0f, 5.0f))
+    return;
+
+  // Par défaut, le bassin circulaire bordé par l'anneau de terre
+  std::vector<float> depth((N + 1) * (N + 1), 0.0f);
+  float waterRadius = N * 0.5f;
+  for (int y = 0; y <= N; ++y)
+    for (int x = 0; x <= N; ++x)
+      if (std::hypot(x - N * 0.5f, y - N * 0.5f) < waterRadius)
+        depth[y * (N + 1) + x] = 1.0f;
+  sim.setBathymetry(depth);
+}
+
 void window_resize(int w, int h)
 {
   glViewport(0, 0, w, h); TEST_OPENGL_ERROR();
@@ -280,17 +361,22 @@ void display()
     boatMovedByUser = false;
   }
   
-  sim.update();
+  sim.advance(DT);
 
   glBindTexture(GL_TEXTURE_2D, heightTex); TEST_OPENGL_ERROR();
   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, N + 1, N + 1,
                   GL_RED, GL_FLOAT, sim.getHeight().data()); TEST_OPENGL_ERROR();
   glBindTexture(GL_TEXTURE_2D, 0); TEST_OPENGL_ERROR();
 
-  glBindTexture(GL_TEXTURE_2D, velocityTex); TEST_OPENGL_ERROR();
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, N + 1, N + 1,
-                  GL_RED, GL_FLOAT, sim.getVelocity().data()); TEST_OPENGL_ERROR();
-  glBindTexture(GL_TEXTURE_2D, 0); TEST_OPENGL_ERROR();
+  // seules les lignes des tuiles recalculées sont renvoyées
+  auto [rowBegin, rowEnd] = surfaceFields.update(sim, DT);
+  if (rowEnd > rowBegin)
+  {
+    glBindTexture(GL_TEXTURE_2D, surfaceTex); TEST_OPENGL_ERROR();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, rowBegin, N + 1, rowEnd - rowBegin, GL_RGBA, GL_HALF_FLOAT,
+                    surfaceFields.getPacked().data() + 4 * size_t(rowBegin) * (N + 1)); TEST_OPENGL_ERROR();
+    glBindTexture(GL_TEXTURE_2D, 0); TEST_OPENGL_ERROR();
+  }
   
   // openGL pour le ciel
   glDepthMask(GL_FALSE); TEST_OPENGL_ERROR();
@@ -328,8 +414,8 @@ void display()
   glUniform1i(glGetUniformLocation(waterProgram, "heightMap"), 0); TEST_OPENGL_ERROR();
 
   glActiveTexture(GL_TEXTURE1); TEST_OPENGL_ERROR();
-  glBindTexture(GL_TEXTURE_2D, velocityTex); TEST_OPENGL_ERROR();
-  glUniform1i(glGetUniformLocation(waterProgram, "velocityMap"), 1); TEST_OPENGL_ERROR();
+  glBindTexture(GL_TEXTURE_2D, surfaceTex); TEST_OPENGL_ERROR();
+  glUniform1i(glGetUniformLocation(waterProgram, "surfaceMap"), 1); TEST_OPENGL_ERROR();
 
   glBindVertexArray(waterVAO); TEST_OPENGL_ERROR();
   glDrawElements(GL_TRIANGLES, waterCount, GL_UNSIGNED_INT, nullptr); TEST_OPENGL_ERROR();
@@ -350,13 +436,10 @@ void display()
   }
 
   // infos sur le bateau
-  int bx = int((boatPos.x / STEP) + N / 2.0f);
-  int bz = int((boatPos.z / STEP) + N / 2.0f);
-  const auto& heights = sim.getHeight();
-  auto [ux, uz] = sim.getLocalVelocity(bx, bz);
+  WaterSample here = sampleSurface(sim, boatPos.x, boatPos.z);
   float boatDrag = 0.02f;
-  boatPos.x += ux * boatDrag;
-  boatPos.z += uz * boatDrag;
+  boatPos.x += here.velX * boatDrag;
+  boatPos.z += here.velZ * boatDrag;
 
   boatPos.x += boatVelocity.x;
   boatPos.z += boatVelocity.y;
@@ -374,21 +457,17 @@ void display()
   glm::vec2 forward(s, c);
   glm::vec2 right(c, -s);
 
-  float hC = heights[bz * (N + 1) + bx];
+  float hC = here.height;
 
-  int bxF = int((boatPos.x + STEP * forward.x) / STEP + N / 2.0f);
-  int bzF = int((boatPos.z + STEP * forward.y) / STEP + N / 2.0f);
-  int bxB = int((boatPos.x - STEP * forward.x) / STEP + N / 2.0f);
-  int bzB = int((boatPos.z - STEP * forward.y) / STEP + N / 2.0f);
-  float hF = heights[std::clamp(bzF, 0, N) * (N + 1) + std::clamp(bxF, 0, N)];
-  float hB = heights[std::clamp(bzB, 0, N) * (N + 1) + std::clamp(bxB, 0, N)];
-
-  int bxR = int((boatPos.x + STEP * right.x) / STEP + N / 2.0f);
-  int bzR = int((boatPos.z + STEP * right.y) / STEP + N / 2.0f);
-  int bxL = int((boatPos.x - STEP * right.x) / STEP + N / 2.0f);
-  int bzL = int((boatPos.z - STEP * right.y) / STEP + N / 2.0f);
-  float hR = heights[std::clamp(bzR, 0, N) * (N + 1) + std::clamp(bxR, 0, N)];
-  float hL = heights[std::clamp(bzL, 0, N) * (N + 1) + std::clamp(bxL, 0, N)];
+  // avant, arrière, droite, gauche
+  const float px[4] = {boatPos.x + STEP * forward.x, boatPos.x - STEP * forward.x,
+                       boatPos.x + STEP * right.x, boatPos.x - STEP * right.x};
+  const float pz[4] = {boatPos.z + STEP * forward.y, boatPos.z - STEP * forward.y,
+                       boatPos.z + STEP * right.y, boatPos.z - STEP * right.y};
+  WaterSample probes[4];
+  sampleSurface(sim, px, pz, 4, probes);
+  float hF = probes[0].height, hB = probes[1].height;
+  float hR = probes[2].height, hL = probes[3].height;
 
   float dx = (hR - hL) * HEIGHT_SCALE / (2.0f * STEP);
   float dz = (hF - hB) * HEIGHT_SCALE / (2.0f * STEP);
@@ -436,6 +515,17 @@ void display()
   glDrawElements(GL_TRIANGLES, sphereCount, GL_UNSIGNED_INT, nullptr); TEST_OPENGL_ERROR();
   glBindVertexArray(0); TEST_OPENGL_ERROR();
 
+  // capture vidéo : relecture asynchrone, avant l'échange des tampons
+  if (capture)
+  {
+    capture->capture(); TEST_OPENGL_ERROR();
+    if (captureFrames > 0 && capture->getStats().captured >= uint64_t(captureFrames))
+    {
+      stop_capture();
+      glutLeaveMainLoop();
+    }
+  }
+
   glutSwapBuffers(); TEST_OPENGL_ERROR();
 }
 
@@ -525,6 +615,16 @@ void keyboard(unsigned char key, int x, int y)
         case 'd':
             boatHeading -= turnStep;
             break;
+        case 'i':
+        {
+            static const char *names[] = {"Euler centré", "Saute-mouton grille C", "RK3"};
+            int next = (int(sim.getIntegrator()) + 1) % 3;
+            std::cout << "Intégrateur : " << names[int(sim.getIntegrator())] << " ("
+                      << sim.getStepsPerSimSecond() << " pas / s simulée) -> "
+                      << names[next] << std::endl;
+            sim.setIntegrator(Integrator(next));
+            break;
+        }
     }
     float maxSpeed = 0.3f;
     float speed = glm::length(boatVelocity);
@@ -533,9 +633,16 @@ void keyboard(unsigned char key, int x, int y)
     }
 }
 
+void close_window()
+{
+  stop_capture();
+}
+
 int main(int argc, char **argv)
 {
   init_glut(argc, argv);
+  parse_args(argc, argv);
+  init_bathymetry();
   if (!init_glew())
   {
     std::cerr << "GLEW init failed\n";
@@ -547,6 +654,7 @@ int main(int argc, char **argv)
   init_drop_mesh();
   init_sky();
   init_land();
+  init_capture();
   glutMainLoop();
   return 0;
 }
\ No newline at end of file
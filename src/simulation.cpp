@@ -1,68 +1,485 @@
 #include "simulation.hpp"
+#include "distributed.hpp"
+#include "bathymetry.hpp"
 #include <cmath>
 #include <algorithm>
+#include <iostream>
+
+// Calcule les lignes intérieures pendant l'échange des halos, puis les deux lignes de bord
+template <class Begin, class Finish, class Rows>
+static void overlapped(int yA, int yB, Begin begin, Finish finish, Rows rows)
+{
+  begin();
+  rows(yA + 1, yB - 1);
+  finish();
+  rows(yA, std::min(yA + 1, yB));
+  if (yB - 1 > yA)
+    rows(yB - 1, yB);
+}
+
+// Profondeur uniforme : le compilateur élimine les multiplications par 1
+// et les différences centrées restent celles d'origine
+struct UniformDepth
+{
+  float u(int) const { return 1.0f; }
+  float v(int) const { return 1.0f; }
+  float h(int) const { return 1.0f; }
+  float gradX(const float *f, int i) const { return f[i + 1] - f[i - 1]; }
+  float gradY(const float *f, int i, int s) const { return f[i + s] - f[i - s]; }
+  float fluxX(const float *q, int i) const { return q[i + 1] - q[i - 1]; }
+  float fluxY(const float *q, int i, int s) const { return q[i + s] - q[i - s]; }
+};
+
+// Grille C : profondeur aux faces, nulle sur une face touchant la terre (mur). Le débit y
+// reste nul, donc la hauteur d'une cellule sèche ne bouge pas sans masque supplémentaire.
+struct FaceDepth
+{
+  const float *cu, *cv;
+  float u(int i) const { return cu[i]; }
+  float v(int i) const { return cv[i]; }
+  float h(int) const { return 1.0f; }
+};
+
+// Schémas collocalisés : profondeur par cellule, faces ouvertes ox (x, x + 1) et oy (y, y + 1).
+// Les différences centrées s'écrivent face par face ; une face fermée (côte) ne porte
+// ni pente ni flux, ce qui revient à un mur réfléchissant.
+struct CellDepth
+{
+  const float *depth, *ox, *oy;
+  float u(int i) const { return depth[i]; }
+  float v(int i) const { return depth[i]; }
+  float h(int) const { return 1.0f; }
+  float gradX(const float *f, int i) const { return ox[i] * (f[i + 1] - f[i]) + ox[i - 1] * (f[i] - f[i - 1]); }
+  float gradY(const float *f, int i, int s) const { return oy[i] * (f[i + s] - f[i]) + oy[i - s] * (f[i] - f[i - s]); }
+  float fluxX(const float *q, int i) const { return ox[i] * (q[i + 1] + q[i]) - ox[i - 1] * (q[i] + q[i - 1]); }
+  float fluxY(const float *q, int i, int s) const { return oy[i] * (q[i + s] + q[i]) - oy[i - s] * (q[i] + q[i - s]); }
+};
 
 Simulation::Simulation(int size, float dx, float dt, float damping)
-    : N(size), dx(dx), dt(dt), damping(damping),
-      h((size + 1) * (size + 1), 0.0f),
-      u((size + 1) * (size + 1), 0.0f),
-      v((size + 1) * (size + 1), 0.0f),
-      h_new((size + 1) * (size + 1), 0.0f),
-      u_new((size + 1) * (size + 1), 0.0f),
-      v_new((size + 1) * (size + 1), 0.0f)
+    : Simulation(size, 0, size + 1, dx, dt, damping)
+{
+}
+
+Simulation::Simulation(int size, int rowBegin, int rowEnd, float dx, float dt, float damping)
+    : N(size), rowBegin(rowBegin), rowEnd(rowEnd), row0(std::max(0, rowBegin - 1)),
+      dx(dx), dt(dt), damping(damping)
 {
+  size_t cells = size_t(std::min(N, rowEnd) - row0 + 1) * (N + 1);
+  for (auto *f : {&h, &u, &v, &h_new, &u_new, &v_new})
+    f->assign(cells, 0.0f);
 }
 
 int Simulation::getSize() const { return N; }
+int Simulation::getRowBegin() const { return rowBegin; }
+int Simulation::getRowEnd() const { return rowEnd; }
+int Simulation::getRowOffset() const { return row0; }
 const std::vector<float> &Simulation::getHeight() const { return h; }
+const std::vector<float> &Simulation::getU() const { return u; }
+const std::vector<float> &Simulation::getV() const { return v; }
+float Simulation::getDx() const { return dx; }
+
+void Simulation::setHaloLinks(HaloLink *b, HaloLink *a)
+{
+  below = b;
+  above = a;
+  haloBuf.resize(3 * size_t(N + 1));
+}
 
 void Simulation::addDrop(int cx, int cy, float amp, int radius)
 {
   float sigma = radius / 2.0f;
   float twoSigma2 = 2.0f * sigma * sigma;
+  int rowLast = std::min(N, rowEnd);
   for (int dy = -radius; dy <= radius; ++dy)
   {
     for (int dx_ = -radius; dx_ <= radius; ++dx_)
     {
       int x = cx + dx_, y = cy + dy;
-      if (x < 0 || x > N || y < 0 || y > N)
+      if (x < 0 || x > N || y < row0 || y > rowLast)
+        continue;
+      if (!wet.empty() && wet[(y - row0) * (N + 1) + x] == 0.0f)
         continue;
       float d2 = float(dx_ * dx_ + dy * dy);
-      h[y * (N + 1) + x] += amp * std::exp(-d2 / twoSigma2);
+      h[(y - row0) * (N + 1) + x] += amp * std::exp(-d2 / twoSigma2);
     }
   }
 }
 
-void Simulation::update()
+void Simulation::setIntegrator(Integrator s)
 {
-  float coeff = g * dt / (2.0f * dx);
-  int stride = N + 1;
+  scheme = s;
+  // getStepsPerSimSecond() mesure le schéma courant
+  steps = 0;
+  simTime = 0.0;
+  precomputeCoefficients();
+  if (scheme == Integrator::RK3 && h_tmp.empty())
+  {
+    h_tmp.assign(h.size(), 0.0f);
+    u_tmp.assign(u.size(), 0.0f);
+    v_tmp.assign(v.size(), 0.0f);
+  }
+}
 
-  // Calcul des nouvelles vitesses
-  for (int y = 1; y < N; ++y)
+Integrator Simulation::getIntegrator() const { return scheme; }
+const std::vector<float> &Simulation::getDepth() const { return depth; }
+const std::vector<float> &Simulation::getDepthU() const
+{
+  return scheme == Integrator::StaggeredLeapfrog ? coefU : depth;
+}
+const std::vector<float> &Simulation::getDepthV() const
+{
+  return scheme == Integrator::StaggeredLeapfrog ? coefV : depth;
+}
+const std::vector<float> &Simulation::getWetMask() const { return wet; }
+
+void Simulation::setBathymetry(const std::vector<float> &globalDepth)
+{
+  size_t stride = N + 1;
+  if (globalDepth.empty())
   {
-    for (int x = 1; x < N; ++x)
+    depth.clear();
+    wet.clear();
+    coefU.clear();
+    coefV.clear();
+    openX.clear();
+    openY.clear();
+    maxDepth = 1.0f;
+    return;
+  }
+  if (globalDepth.size() != stride * stride)
+  {
+    std::cerr << "Bathymétrie : " << globalDepth.size() << " valeurs pour une grille de "
+              << stride * stride << std::endl;
+    return;
+  }
+  float globalMax = 0.0f;
+  for (float d : globalDepth)
+    globalMax = std::max(globalMax, d);
+  setBathymetry(std::vector<float>(globalDepth.begin() + row0 * stride, globalDepth.begin() + row0 * stride + h.size()),
+                globalMax);
+}
+
+void Simulation::setBathymetry(const std::vector<float> &localDepth, float globalMaxDepth)
+{
+  if (localDepth.size() != h.size())
+  {
+    std::cerr << "Bathymétrie : " << localDepth.size() << " valeurs pour " << h.size()
+              << " cellules stockées" << std::endl;
+    return;
+  }
+
+  // En dessous de 1 mm, la cellule est considérée sèche
+  const float minDepth = 1e-3f;
+  maxDepth = globalMaxDepth;
+  depth = localDepth;
+  wet.resize(depth.size());
+  for (size_t i = 0; i < depth.size(); ++i)
+  {
+    if (depth[i] < minDepth)
     {
-      int i = y * stride + x;
-      float dhdx = (h[i + 1] - h[i - 1]);
-      float dhdy = (h[i + stride] - h[i - stride]);
-      u_new[i] = damping * (u[i] - coeff * dhdx);
-      v_new[i] = damping * (v[i] - coeff * dhdy);
+      depth[i] = 0.0f;
+      h[i] = h_new[i] = 0.0f;
     }
+    wet[i] = depth[i] > 0.0f ? 1.0f : 0.0f;
   }
+  precomputeCoefficients();
+}
 
-  // Calcul de la nouvelle hauteur
-  float inv2dx = dt / (2.0f * dx);
-  for (int y = 1; y < N; ++y)
+bool Simulation::loadBathymetry(const std::string &path, float minElevation, float maxElevation)
+{
+  // Lecture en flux : seules les lignes stockées du sous-domaine sont gardées, mais la
+  // profondeur maximale, qui fixe le sous-pas de toutes les bandes, porte sur toute la grille
+  size_t stride = N + 1;
+  std::vector<float> local(h.size()), line(stride);
+  int rowLast = row0 + int(h.size() / stride) - 1;
+  float globalMax = 0.0f;
+  bool ok = visitHeightmapRows(path, N, [&](int y, const float *row) {
+    line.assign(row, row + stride);
+    std::vector<float> d = depthFromHeightmap(line, minElevation, maxElevation);
+    globalMax = std::max(globalMax, *std::max_element(d.begin(), d.end()));
+    if (y >= row0 && y <= rowLast)
+      std::copy(d.begin(), d.end(), local.begin() + (y - row0) * stride);
+  });
+  if (!ok)
+    return false;
+  setBathymetry(local, globalMax);
+  return true;
+}
+
+void Simulation::precomputeCoefficients()
+{
+  // Grille C : profondeur aux faces, nulle si la face touche une cellule sèche.
+  // Schémas collocalisés : faces ouvertes entre deux cellules mouillées.
+  if (depth.empty())
+    return;
+  int stride = N + 1;
+  int rows = int(depth.size()) / stride;
+  bool staggered = scheme == Integrator::StaggeredLeapfrog;
+  std::vector<float> &a = staggered ? coefU : openX, &b = staggered ? coefV : openY;
+  std::vector<float> &unusedA = staggered ? openX : coefU, &unusedB = staggered ? openY : coefV;
+  a.resize(depth.size());
+  b.resize(depth.size());
+  unusedA.clear();
+  unusedB.clear();
+  for (int y = 0; y < rows; ++y)
   {
-    for (int x = 1; x < N; ++x)
+    for (int x = 0; x <= N; ++x)
     {
       int i = y * stride + x;
-      float du = (u[i + 1] - u[i - 1]);
-      float dv = (v[i + stride] - v[i - stride]);
-      h_new[i] = h[i] - inv2dx * (du + dv);
+      if (staggered)
+      {
+        coefU[i] = x < N ? std::min(depth[i], depth[i + 1]) : 0.0f;
+        coefV[i] = y + 1 < rows ? std::min(depth[i], depth[i + stride]) : depth[i];
+      }
+      else
+      {
+        openX[i] = x < N ? wet[i] * wet[i + 1] : 0.0f;
+        openY[i] = y + 1 < rows ? wet[i] * wet[i + stride] : 0.0f;
+      }
     }
   }
+  const std::vector<float> &closedU = staggered ? coefU : depth, &closedV = staggered ? coefV : depth;
+  for (size_t i = 0; i < depth.size(); ++i)
+  {
+    if (closedU[i] == 0.0f)
+      u[i] = u_new[i] = 0.0f;
+    if (closedV[i] == 0.0f)
+      v[i] = v_new[i] = 0.0f;
+  }
+}
+
+void Simulation::setCfl(float c) { cfl = c; }
+
+float Simulation::getStepsPerSimSecond() const
+{
+  return simTime > 0.0 ? float(steps / simTime) : 0.0f;
+}
+
+float Simulation::stableTimeStep() const
+{
+  // Nombre de Courant max (c dt / dx) pour la vitesse des ondes c = sqrt(g H)
+  float c = std::sqrt(g * maxDepth);
+  float courant;
+  switch (scheme)
+  {
+  case Integrator::StaggeredLeapfrog:
+    courant = 1.0f / std::sqrt(2.0f);
+    break;
+  case Integrator::RK3:
+    // |1 + z + z²/2 + z³/6| <= 1 sur l'axe imaginaire jusqu'à sqrt(3), valeurs propres <= sqrt(2) c / dx
+    courant = std::sqrt(3.0f) / std::sqrt(2.0f);
+    break;
+  default:
+    // Euler explicite amplifie de sqrt(1 + 2 C²) : seul l'amortissement d = damping^(dtStep / dt)
+    // par sous-pas le stabilise. Il n'agit que sur u et v, le déterminant du pas vaut donc
+    // d (1 + 2 C²) ; comme 1 + 2 C² <= exp(2 C²), il reste <= 1 dès que
+    // dtStep <= -ln(damping) dx² / (2 g H dt)
+    if (damping >= 1.0f || c <= 0.0f)
+      return dt;
+    return cfl * -std::log(damping) * dx * dx / (2.0f * c * c * dt);
+  }
+  if (courant <= 0.0f || c <= 0.0f)
+    return dt;
+  return cfl * courant * dx / c;
+}
+
+void Simulation::update()
+{
+  step(dt);
+}
+
+int Simulation::advance(float duration)
+{
+  if (duration <= 0.0f)
+    return 0;
+  int n = std::max(1, int(std::ceil(duration / stableTimeStep())));
+  float dtStep = duration / n;
+  for (int k = 0; k < n; ++k)
+    step(dtStep);
+  return n;
+}
+
+void Simulation::step(float dtStep)
+{
+  // L'amortissement est défini par pas de durée dt
+  float d = dtStep == dt ? damping : std::pow(damping, dtStep / dt);
+  if (depth.empty())
+    stepWith(dtStep, d, UniformDepth{});
+  else if (scheme == Integrator::StaggeredLeapfrog)
+    stepStaggeredLeapfrog(dtStep, d, FaceDepth{coefU.data(), coefV.data()});
+  else
+    stepWith(dtStep, d, CellDepth{depth.data(), openX.data(), openY.data()});
+  simTime += dtStep;
+  ++steps;
+}
+
+template <class Coef>
+void Simulation::stepWith(float dtStep, float d, Coef c)
+{
+  switch (scheme)
+  {
+  case Integrator::StaggeredLeapfrog:
+    stepStaggeredLeapfrog(dtStep, d, c);
+    break;
+  case Integrator::RK3:
+    stepRK3(dtStep, d, c);
+    break;
+  default:
+    stepForwardCentered(dtStep, d, c);
+    break;
+  }
+}
+
+void Simulation::beginExchange(std::vector<float> &a, std::vector<float> &b, std::vector<float> &c)
+{
+  // Envoie les lignes possédées en bord de sous-domaine
+  size_t stride = N + 1;
+  auto send = [&](HaloLink *link, int y) {
+    size_t off = size_t(y - row0) * stride;
+    float *o = haloBuf.data();
+    for (auto *f : {&a, &b, &c})
+      o = std::copy(f->begin() + off, f->begin() + off + stride, o);
+    link->send(haloBuf.data(), haloBuf.size());
+  };
+  if (below)
+    send(below, rowBegin);
+  if (above)
+    send(above, rowEnd - 1);
+}
+
+void Simulation::finishExchange(std::vector<float> &a, std::vector<float> &b, std::vector<float> &c)
+{
+  size_t stride = N + 1;
+  auto recv = [&](HaloLink *link, int y) {
+    link->recv(haloBuf.data(), haloBuf.size());
+    size_t off = size_t(y - row0) * stride;
+    const float *in = haloBuf.data();
+    for (auto *f : {&a, &b, &c})
+    {
+      std::copy(in, in + stride, f->begin() + off);
+      in += stride;
+    }
+  };
+  if (below)
+    recv(below, rowBegin - 1);
+  if (above)
+    recv(above, rowEnd);
+  if (below)
+    below->complete();
+  if (above)
+    above->complete();
+}
+
+// Noyaux d'une ligne, cellules [i0, i1). Les paramètres restrict dispensent GCC des tests
+// de recouvrement à l'exécution, qu'il abandonne (sans vectoriser) au-delà de quelques tableaux ;
+// noinline : une fois inlinés, il perd restrict et relit les pointeurs de Coef à chaque cellule.
+template <class Coef>
+__attribute__((noinline)) static void forwardCenteredVelocityRow(int i0, int i1, int stride, float coeff, float d,
+                                                                 Coef c, const float *__restrict h,
+                                                                 const float *__restrict u, const float *__restrict v,
+                                                                 float *__restrict un, float *__restrict vn)
+{
+  for (int i = i0; i < i1; ++i)
+  {
+    float dhdx = c.gradX(h, i);
+    float dhdy = c.gradY(h, i, stride);
+    un[i] = d * (u[i] - coeff * c.u(i) * dhdx);
+    vn[i] = d * (v[i] - coeff * c.v(i) * dhdy);
+  }
+}
+
+template <class Coef>
+__attribute__((noinline)) static void forwardCenteredHeightRow(int i0, int i1, int stride, float inv2dx, Coef c,
+                                                               const float *__restrict h, const float *__restrict u,
+                                                               const float *__restrict v, float *__restrict hn)
+{
+  for (int i = i0; i < i1; ++i)
+  {
+    float du = c.fluxX(u, i);
+    float dv = c.fluxY(v, i, stride);
+    hn[i] = h[i] - inv2dx * c.h(i) * (du + dv);
+  }
+}
+
+template <class Coef>
+__attribute__((noinline)) static void leapfrogVelocityRow(int i0, int i1, int stride, float coeff, float d, Coef c,
+                                                          const float *__restrict h, const float *__restrict u,
+                                                          const float *__restrict v, float *__restrict un,
+                                                          float *__restrict vn)
+{
+  for (int i = i0; i < i1; ++i)
+  {
+    un[i] = d * (u[i] - coeff * c.u(i) * (h[i + 1] - h[i]));
+    vn[i] = d * (v[i] - coeff * c.v(i) * (h[i + stride] - h[i]));
+  }
+}
+
+template <class Coef>
+__attribute__((noinline)) static void leapfrogHeightRow(int i0, int i1, int stride, float invdx, Coef c,
+                                                        const float *__restrict h, const float *__restrict un,
+                                                        const float *__restrict vn, float *__restrict hn)
+{
+  for (int i = i0; i < i1; ++i)
+  {
+    float du = (un[i] - un[i - 1]);
+    float dv = (vn[i] - vn[i - stride]);
+    hn[i] = h[i] - invdx * c.h(i) * (du + dv);
+  }
+}
+
+template <class Coef>
+__attribute__((noinline)) static void rk3Row(int i0, int i1, int stride, float coeff, float inv2dx, float a, float b,
+                                             float d, Coef c, const float *__restrict h0, const float *__restrict u0,
+                                             const float *__restrict v0, const float *__restrict h,
+                                             const float *__restrict u, const float *__restrict v, float *__restrict ho,
+                                             float *__restrict uo, float *__restrict vo)
+{
+  // Deux boucles : GCC ne vectorise pas les trois champs ensemble
+  for (int i = i0; i < i1; ++i)
+  {
+    float un = u[i] - coeff * c.u(i) * c.gradX(h, i);
+    float vn = v[i] - coeff * c.v(i) * c.gradY(h, i, stride);
+    uo[i] = d * (a * u0[i] + b * un);
+    vo[i] = d * (a * v0[i] + b * vn);
+  }
+  for (int i = i0; i < i1; ++i)
+  {
+    float hn = h[i] - inv2dx * c.h(i) * (c.fluxX(u, i) + c.fluxY(v, i, stride));
+    // h0 + b (hn - h0) plutôt que a h0 + b hn : à hn ≈ h0 l'arrondi ne biaise pas la masse
+    ho[i] = h0[i] + b * (hn - h0[i]);
+  }
+}
+
+template <class Coef>
+void Simulation::forwardCenteredRows(int y0, int y1, float dtStep, float d, Coef c)
+{
+  float coeff = g * dtStep / (2.0f * dx);
+  int stride = N + 1;
+
+  // Calcul des nouvelles vitesses
+  for (int y = y0; y < y1; ++y)
+  {
+    int row = (y - row0) * stride;
+    forwardCenteredVelocityRow(row + 1, row + N, stride, coeff, d, c, h.data(), u.data(), v.data(),
+                               u_new.data(), v_new.data());
+  }
+
+  // Calcul de la nouvelle hauteur
+  float inv2dx = dtStep / (2.0f * dx);
+  for (int y = y0; y < y1; ++y)
+  {
+    int row = (y - row0) * stride;
+    forwardCenteredHeightRow(row + 1, row + N, stride, inv2dx, c, h.data(), u.data(), v.data(), h_new.data());
+  }
+}
+
+template <class Coef>
+void Simulation::stepForwardCentered(float dtStep, float d, Coef c)
+{
+  int yA = std::max(1, rowBegin), yB = std::min(N, rowEnd);
+  overlapped(
+      yA, yB, [&] { beginExchange(h, u, v); }, [&] { finishExchange(h, u, v); },
+      [&](int y0, int y1) { forwardCenteredRows(y0, y1, dtStep, d, c); });
 
   // Échanges
   std::swap(h, h_new);
@@ -70,17 +487,151 @@ void Simulation::update()
   std::swap(v, v_new);
 }
 
+template <class Coef>
+void Simulation::leapfrogVelocityRows(int y0, int y1, float dtStep, float d, Coef c)
+{
+  // u[y][x] est en (x + 1/2, y), v[y][x] en (x, y + 1/2) ; les faces
+  // x = 0, x = N - 1, y = 0, y = N - 1 sont des murs (vitesse nulle)
+  float coeff = g * dtStep / dx;
+  int stride = N + 1;
+  y0 = std::max(y0, 1);
+  y1 = std::min(y1, N);
+
+  for (int y = y0; y < y1; ++y)
+  {
+    int row = (y - row0) * stride;
+    leapfrogVelocityRow(row + 1, row + N, stride, coeff, d, c, h.data(), u.data(), v.data(), u_new.data(),
+                        v_new.data());
+    u_new[row + N - 1] = 0.0f;
+    if (y == N - 1)
+      std::fill(v_new.begin() + row, v_new.begin() + row + stride, 0.0f);
+  }
+}
+
+template <class Coef>
+void Simulation::leapfrogHeightRows(int y0, int y1, float dtStep, Coef c)
+{
+  // La hauteur utilise les vitesses déjà mises à jour
+  float invdx = dtStep / dx;
+  int stride = N + 1;
+  for (int y = y0; y < y1; ++y)
+  {
+    int row = (y - row0) * stride;
+    leapfrogHeightRow(row + 1, row + N, stride, invdx, c, h.data(), u_new.data(), v_new.data(), h_new.data());
+  }
+}
+
+template <class Coef>
+void Simulation::stepStaggeredLeapfrog(float dtStep, float d, Coef c)
+{
+  // v_new de la ligne y dépend de h en y + 1 et h_new de v_new en y - 1 : le halo
+  // du bas est recalculé localement pour ne faire qu'un échange par pas
+  int yA = std::max(1, rowBegin), yB = std::min(N, rowEnd);
+  beginExchange(h, u, v);
+  leapfrogVelocityRows(yA, yB - 1, dtStep, d, c);
+  leapfrogHeightRows(yA + 1, yB - 1, dtStep, c);
+  finishExchange(h, u, v);
+  leapfrogVelocityRows(rowBegin - 1, yA, dtStep, d, c);
+  leapfrogVelocityRows(std::max(yA, yB - 1), yB, dtStep, d, c);
+  leapfrogHeightRows(yA, std::min(yA + 1, yB), dtStep, c);
+  if (yB - 1 > yA)
+    leapfrogHeightRows(yB - 1, yB, dtStep, c);
+
+  std::swap(h, h_new);
+  std::swap(u, u_new);
+  std::swap(v, v_new);
+}
+
+template <class Coef>
+void Simulation::rk3Rows(int y0, int y1, const std::vector<float> &h0, const std::vector<float> &u0, const std::vector<float> &v0,
+                         const std::vector<float> &hin, const std::vector<float> &uin, const std::vector<float> &vin,
+                         std::vector<float> &hout, std::vector<float> &uout, std::vector<float> &vout,
+                         float a, float b, float dtStep, float d, Coef c)
+{
+  // out = a q0 + b (q + dt L(q))
+  float coeff = g * dtStep / (2.0f * dx);
+  float inv2dx = dtStep / (2.0f * dx);
+  int stride = N + 1;
+
+  for (int y = y0; y < y1; ++y)
+  {
+    int row = (y - row0) * stride;
+    rk3Row(row + 1, row + N, stride, coeff, inv2dx, a, b, d, c, h0.data(), u0.data(), v0.data(), hin.data(),
+           uin.data(), vin.data(), hout.data(), uout.data(), vout.data());
+  }
+}
+
+template <class Coef>
+void Simulation::rk3Stage(const std::vector<float> &h0, const std::vector<float> &u0, const std::vector<float> &v0,
+                          std::vector<float> &hin, std::vector<float> &uin, std::vector<float> &vin,
+                          std::vector<float> &hout, std::vector<float> &uout, std::vector<float> &vout,
+                          float a, float b, float dtStep, float d, Coef c)
+{
+  int yA = std::max(1, rowBegin), yB = std::min(N, rowEnd);
+  overlapped(
+      yA, yB, [&] { beginExchange(hin, uin, vin); }, [&] { finishExchange(hin, uin, vin); },
+      [&](int y0, int y1) { rk3Rows(y0, y1, h0, u0, v0, hin, uin, vin, hout, uout, vout, a, b, dtStep, d, c); });
+
+  // Les bords de la grille restent ceux de q0
+  int stride = N + 1;
+  for (auto [src, dst] : {std::pair{&h0, &hout}, {&u0, &uout}, {&v0, &vout}})
+  {
+    for (int y = rowBegin; y < rowEnd; ++y)
+    {
+      int row = (y - row0) * stride;
+      if (y == 0 || y == N)
+        std::copy(src->begin() + row, src->begin() + row + stride, dst->begin() + row);
+      else
+      {
+        (*dst)[row] = (*src)[row];
+        (*dst)[row + N] = (*src)[row + N];
+      }
+    }
+  }
+}
+
+template <class Coef>
+void Simulation::stepRK3(float dtStep, float d, Coef c)
+{
+  // Shu-Osher : q1 = q + dt L(q), q2 = 3/4 q + 1/4 (q1 + dt L(q1)), q' = 1/3 q + 2/3 (q2 + dt L(q2))
+  // Poids de somme exactement 1 en flottant (1/3f + 2/3f dépasse 1) : sinon la masse dérive
+  rk3Stage(h, u, v, h, u, v, h_tmp, u_tmp, v_tmp, 0.0f, 1.0f, dtStep, 1.0f, c);
+  rk3Stage(h, u, v, h_tmp, u_tmp, v_tmp, h_new, u_new, v_new, 0.75f, 0.25f, dtStep, 1.0f, c);
+  rk3Stage(h, u, v, h_new, u_new, v_new, h_tmp, u_tmp, v_tmp, 1.0f / 3.0f, 1.0f - 1.0f / 3.0f, dtStep, d, c);
+
+  std::swap(h, h_tmp);
+  std::swap(u, u_tmp);
+  std::swap(v, v_tmp);
+}
+
 std::vector<float> Simulation::getVelocity() const
 {
   std::vector<float> velocity;
-  velocity.resize((N+1)*(N+1));
-  for (int i = 0; i < (N+1)*(N+1); ++i)
-      velocity[i] = std::sqrt(u[i]*u[i] + v[i]*v[i]);
+  velocity.resize(h.size());
+  if (depth.empty())
+  {
+    for (size_t i = 0; i < h.size(); ++i)
+        velocity[i] = std::sqrt(u[i]*u[i] + v[i]*v[i]);
+    return velocity;
+  }
+  // u, v sont des débits avec une bathymétrie
+  for (size_t i = 0; i < h.size(); ++i)
+  {
+      auto [vx, vz] = localVelocity(int(i));
+      velocity[i] = std::sqrt(vx*vx + vz*vz);
+  }
   return velocity;
 }
 
 std::pair<float, float> Simulation::getLocalVelocity(int x, int z) const
 {
-    int idx = z * (N + 1) + x;
-    return {u[idx], v[idx]};
+    return localVelocity((z - row0) * (N + 1) + x);
+}
+
+std::pair<float, float> Simulation::localVelocity(int i) const
+{
+    if (depth.empty())
+        return {u[i], v[i]};
+    const std::vector<float> &du = getDepthU(), &dv = getDepthV();
+    return {du[i] > 0.0f ? u[i] / du[i] : 0.0f, dv[i] > 0.0f ? v[i] / dv[i] : 0.0f};
 }
@@ -0,0 +1,245 @@
+#include "water_query.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define WATER_QUERY_AVX2 1
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+SurfaceSnapshot::SurfaceSnapshot(const Simulation &sim)
+    : N(sim.getSize()), row0(sim.getRowOffset()),
+      rowLast(sim.getRowOffset() + int(sim.getHeight().size()) / (sim.getSize() + 1) - 1),
+      dx(sim.getDx()), invDx(1.0f / sim.getDx()),
+      uShift(sim.getIntegrator() == Integrator::StaggeredLeapfrog ? 0.5f : 0.0f),
+      vShift(uShift),
+      h(sim.getHeight()), u(sim.getU()), v(sim.getV())
+{
+  // Avec une bathymétrie, le solveur porte des débits : on revient aux vitesses
+  const std::vector<float> &depthU = sim.getDepthU(), &depthV = sim.getDepthV();
+  for (size_t i = 0; i < depthU.size(); ++i)
+  {
+    u[i] = depthU[i] > 0.0f ? u[i] / depthU[i] : 0.0f;
+    v[i] = depthV[i] > 0.0f ? v[i] / depthV[i] : 0.0f;
+  }
+}
+
+// Cellule contenant (gx, gz) et poids bilinéaires, bornés à la grille stockée
+static inline void cell(float gx, float gz, int N, int row0, int rowLast,
+                        int &i, float &fx, float &fz)
+{
+  // Une coordonnée NaN est ramenée à la borne basse, comme par _mm256_max_ps en AVX2
+  gx = std::min(std::max(0.0f, gx), float(N));
+  gz = std::min(std::max(float(row0), gz), float(rowLast));
+  int x0 = std::min(int(gx), N - 1);
+  int z0 = std::min(int(gz), rowLast - 1);
+  fx = gx - x0;
+  fz = gz - z0;
+  i = (z0 - row0) * (N + 1) + x0;
+}
+
+static inline float bilerp(float a, float b, float c, float d, float fx, float fz,
+                           float *ddx = nullptr, float *ddz = nullptr)
+{
+  float top = a + fx * (b - a);
+  float bot = c + fx * (d - c);
+  if (ddx)
+  {
+    *ddx = (b - a) + fz * ((d - c) - (b - a));
+    *ddz = bot - top;
+  }
+  return top + fz * (bot - top);
+}
+
+static inline float bilerp(const float *f, int i, int stride, float fx, float fz,
+                           float *ddx = nullptr, float *ddz = nullptr)
+{
+  return bilerp(f[i], f[i + 1], f[i + stride], f[i + stride + 1], fx, fz, ddx, ddz);
+}
+
+// Débit ramené à une vitesse à chaque coin (0 sur la terre ou une face fermée)
+static inline float bilerpVelocity(const float *q, const float *depth, int i, int stride, float fx, float fz)
+{
+  if (!depth)
+    return bilerp(q, i, stride, fx, fz);
+  auto vel = [&](int j) { return depth[j] > 0.0f ? q[j] / depth[j] : 0.0f; };
+  return bilerp(vel(i), vel(i + 1), vel(i + stride), vel(i + stride + 1), fx, fz);
+}
+
+// Champs interrogés : ceux d'un instantané ou, sans copie, ceux de la simulation
+struct SurfaceFields
+{
+  const float *h, *u, *v;
+  const float *depthU, *depthV; // u, v sont des débits si non nuls
+  int N, row0, rowLast;
+  float invDx, uShift, vShift;
+};
+
+static void sampleFields(const SurfaceFields &f, const float *px, const float *pz, size_t count, WaterSample *out)
+{
+  int N = f.N, stride = N + 1;
+  float half = N / 2.0f;
+  for (size_t k = 0; k < count; ++k)
+  {
+    float gx = px[k] * f.invDx + half, gz = pz[k] * f.invDx + half;
+    int i;
+    float fx, fz, ddx, ddz;
+    cell(gx, gz, N, f.row0, f.rowLast, i, fx, fz);
+    out[k].height = bilerp(f.h, i, stride, fx, fz, &ddx, &ddz);
+    out[k].slopeX = ddx * f.invDx;
+    out[k].slopeZ = ddz * f.invDx;
+
+    cell(gx - f.uShift, gz, N, f.row0, f.rowLast, i, fx, fz);
+    out[k].velX = bilerpVelocity(f.u, f.depthU, i, stride, fx, fz);
+    cell(gx, gz - f.vShift, N, f.row0, f.rowLast, i, fx, fz);
+    out[k].velZ = bilerpVelocity(f.v, f.depthV, i, stride, fx, fz);
+  }
+}
+
+void SurfaceSnapshot::sampleScalar(const float *px, const float *pz, size_t count, WaterSample *out) const
+{
+  sampleFields({h.data(), u.data(), v.data(), nullptr, nullptr, N, row0, rowLast, invDx, uShift, vShift}, px, pz,
+               count, out);
+}
+
+void sampleSurface(const Simulation &sim, const float *x, const float *z, size_t count, WaterSample *out)
+{
+  int N = sim.getSize();
+  float shift = sim.getIntegrator() == Integrator::StaggeredLeapfrog ? 0.5f : 0.0f;
+  const std::vector<float> &depthU = sim.getDepthU(), &depthV = sim.getDepthV();
+  SurfaceFields f{sim.getHeight().data(), sim.getU().data(), sim.getV().data(),
+                  depthU.empty() ? nullptr : depthU.data(), depthV.empty() ? nullptr : depthV.data(),
+                  N, sim.getRowOffset(), sim.getRowOffset() + int(sim.getHeight().size()) / (N + 1) - 1,
+                  1.0f / sim.getDx(), shift, shift};
+  sampleFields(f, x, z, count, out);
+}
+
+WaterSample sampleSurface(const Simulation &sim, float x, float z)
+{
+  WaterSample s;
+  sampleSurface(sim, &x, &z, 1, &s);
+  return s;
+}
+
+#ifdef WATER_QUERY_AVX2
+struct GridAVX2
+{
+  __m256 maxX, minZ, maxZ;
+  __m256i cellMaxX, cellMinZ, cellMaxZ, stride;
+};
+
+TARGET_AVX2 static inline void cellAVX2(__m256 gx, __m256 gz, const GridAVX2 &g,
+                                        __m256i &i, __m256 &fx, __m256 &fz)
+{
+  gx = _mm256_min_ps(_mm256_max_ps(gx, _mm256_setzero_ps()), g.maxX);
+  gz = _mm256_min_ps(_mm256_max_ps(gz, g.minZ), g.maxZ);
+  __m256i x0 = _mm256_min_epi32(_mm256_cvttps_epi32(gx), g.cellMaxX);
+  __m256i z0 = _mm256_min_epi32(_mm256_cvttps_epi32(gz), g.cellMaxZ);
+  fx = _mm256_sub_ps(gx, _mm256_cvtepi32_ps(x0));
+  fz = _mm256_sub_ps(gz, _mm256_cvtepi32_ps(z0));
+  i = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(z0, g.cellMinZ), g.stride), x0);
+}
+
+TARGET_AVX2 static inline __m256 bilerpAVX2(const float *f, __m256i i, __m256i stride, __m256 fx, __m256 fz,
+                                            __m256 *ddx = nullptr, __m256 *ddz = nullptr)
+{
+  const __m256i one = _mm256_set1_epi32(1);
+  __m256i j = _mm256_add_epi32(i, stride);
+  __m256 a = _mm256_i32gather_ps(f, i, 4);
+  __m256 b = _mm256_i32gather_ps(f, _mm256_add_epi32(i, one), 4);
+  __m256 c = _mm256_i32gather_ps(f, j, 4);
+  __m256 d = _mm256_i32gather_ps(f, _mm256_add_epi32(j, one), 4);
+  __m256 ab = _mm256_sub_ps(b, a), cd = _mm256_sub_ps(d, c);
+  __m256 top = _mm256_fmadd_ps(fx, ab, a);
+  __m256 bot = _mm256_fmadd_ps(fx, cd, c);
+  __m256 tb = _mm256_sub_ps(bot, top);
+  if (ddx)
+  {
+    *ddx = _mm256_fmadd_ps(fz, _mm256_sub_ps(cd, ab), ab);
+    *ddz = tb;
+  }
+  return _mm256_fmadd_ps(fz, tb, top);
+}
+
+TARGET_AVX2 void SurfaceSnapshot::sampleAVX2(const float *px, const float *pz, size_t count, WaterSample *out) const
+{
+  GridAVX2 g;
+  g.maxX = _mm256_set1_ps(float(N));
+  g.minZ = _mm256_set1_ps(float(row0));
+  g.maxZ = _mm256_set1_ps(float(rowLast));
+  g.cellMaxX = _mm256_set1_epi32(N - 1);
+  g.cellMinZ = _mm256_set1_epi32(row0);
+  g.cellMaxZ = _mm256_set1_epi32(rowLast - 1);
+  g.stride = _mm256_set1_epi32(N + 1);
+  const __m256 inv = _mm256_set1_ps(invDx), half = _mm256_set1_ps(N / 2.0f);
+  const __m256 us = _mm256_set1_ps(uShift), vs = _mm256_set1_ps(vShift);
+
+  alignas(32) float res[5][8];
+  size_t k = 0;
+  for (; k + 8 <= count; k += 8)
+  {
+    __m256 gx = _mm256_fmadd_ps(_mm256_loadu_ps(px + k), inv, half);
+    __m256 gz = _mm256_fmadd_ps(_mm256_loadu_ps(pz + k), inv, half);
+    __m256i i;
+    __m256 fx, fz, ddx, ddz;
+
+    cellAVX2(gx, gz, g, i, fx, fz);
+    _mm256_store_ps(res[0], bilerpAVX2(h.data(), i, g.stride, fx, fz, &ddx, &ddz));
+    _mm256_store_ps(res[1], _mm256_mul_ps(ddx, inv));
+    _mm256_store_ps(res[2], _mm256_mul_ps(ddz, inv));
+
+    cellAVX2(_mm256_sub_ps(gx, us), gz, g, i, fx, fz);
+    _mm256_store_ps(res[3], bilerpAVX2(u.data(), i, g.stride, fx, fz));
+    cellAVX2(gx, _mm256_sub_ps(gz, vs), g, i, fx, fz);
+    _mm256_store_ps(res[4], bilerpAVX2(v.data(), i, g.stride, fx, fz));
+
+    for (int l = 0; l < 8; ++l)
+      out[k + l] = {res[0][l], res[1][l], res[2][l], res[3][l], res[4][l]};
+  }
+  sampleScalar(px + k, pz + k, count - k, out + k);
+}
+#else
+void SurfaceSnapshot::sampleAVX2(const float *px, const float *pz, size_t count, WaterSample *out) const
+{
+  sampleScalar(px, pz, count, out);
+}
+#endif
+
+void SurfaceSnapshot::sampleBatch(const float *px, const float *pz, size_t count, WaterSample *out) const
+{
+#ifdef WATER_QUERY_AVX2
+  static const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  if (avx2)
+  {
+    sampleAVX2(px, pz, count, out);
+    return;
+  }
+#endif
+  sampleScalar(px, pz, count, out);
+}
+
+WaterSample SurfaceSnapshot::sample(float x, float z) const
+{
+  WaterSample s;
+  sampleScalar(&x, &z, 1, &s);
+  return s;
+}
+
+void SurfaceSnapshot::sample(const float *x, const float *z, size_t count, WaterSample *out, int threads) const
+{
+  parallelFor(
+      0, count, 16384, [&](size_t b, size_t e) { sampleBatch(x + b, z + b, e - b, out + b); }, threads);
+}
+
+void SurfacePublisher::publish(const Simulation &sim)
+{
+  std::atomic_store(&snapshot, std::shared_ptr<const SurfaceSnapshot>(std::make_shared<SurfaceSnapshot>(sim)));
+}
+
+std::shared_ptr<const SurfaceSnapshot> SurfacePublisher::current() const
+{
+  return std::atomic_load(&snapshot);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "simulation.hpp"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Assertions minimales : un test échoué est signalé sans interrompre les suivants
+static int failures = 0;
+
+#define CHECK(cond, ...)                                              \
+  do {                                                                \
+    if (!(cond))                                                      \
+    {                                                                 \
+      std::fprintf(stderr, "%s:%d : échec de %s : ", __FILE__, __LINE__, #cond); \
+      std::fprintf(stderr, __VA_ARGS__);                              \
+      std::fprintf(stderr, "\n");                                     \
+      ++failures;                                                     \
+    }                                                                 \
+  } while (0)
+
+static const char *const schemeNames[] = {"euler", "leapfrog", "rk3"};
+static const Integrator schemes[] = {Integrator::ForwardCentered, Integrator::StaggeredLeapfrog, Integrator::RK3};
+
+// Scénario de référence : goutte gaussienne décentrée sur une grille au repos
+inline Simulation makeScenario(int size, Integrator scheme, float damping, int cx, int cy)
+{
+  Simulation sim(size, 1.0f, 0.016f, damping);
+  sim.setIntegrator(scheme);
+  sim.addDrop(cx, cy, 1.0f, 5);
+  return sim;
+}
+
+// Bassin circulaire centré de rayon `radius` cellules, profondeur depthFn(x, y) ; terre au-delà
+template <class F>
+std::vector<float> makeBasin(int size, float radius, F depthFn)
+{
+  std::vector<float> depth((size + 1) * (size + 1), 0.0f);
+  for (int y = 0; y <= size; ++y)
+    for (int x = 0; x <= size; ++x)
+      if (std::hypot(x - size * 0.5f, y - size * 0.5f) < radius)
+        depth[y * (size + 1) + x] = depthFn(x, y);
+  return depth;
+}
+
+inline double totalMass(const Simulation &sim)
+{
+  double m = 0.0;
+  for (float h : sim.getHeight())
+    m += h;
+  return m;
+}
+
+// Énergie de l'onde linéarisée : (g h² + (u² + v²) / H) / 2 par cellule, H = 1 sans bathymétrie
+inline double totalEnergy(const Simulation &sim)
+{
+  const std::vector<float> &h = sim.getHeight(), &u = sim.getU(), &v = sim.getV();
+  const std::vector<float> &depth = sim.getDepth();
+  double e = 0.0;
+  for (size_t i = 0; i < h.size(); ++i)
+  {
+    double kinetic = double(u[i]) * u[i] + double(v[i]) * v[i];
+    if (!depth.empty())
+      kinetic = depth[i] > 0.0f ? kinetic / depth[i] : 0.0;
+    e += 0.5 * (9.81 * double(h[i]) * h[i] + kinetic);
+  }
+  return e;
+}
+
+inline int report(const char *name)
+{
+  if (failures)
+    std::fprintf(stderr, "%s : %d vérification(s) en échec\n", name, failures);
+  else
+    std::printf("%s : OK\n", name);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#include "test_common.hpp"
+#include "derived_fields.hpp"
+#include <algorithm>
+
+static const int N = 128;
+static const float DT = 0.016f;
+
+// Lignes où deux empaquetages diffèrent, [premier, dernier + 1) ; {0, 0} si identiques
+static std::pair<int, int> changedRows(const std::vector<uint16_t> &a, const std::vector<uint16_t> &b)
+{
+  int stride = N + 1, lo = stride, hi = 0;
+  for (size_t k = 0; k < a.size(); ++k)
+    if (a[k] != b[k])
+    {
+      int y = int(k / (4 * stride));
+      lo = std::min(lo, y);
+      hi = std::max(hi, y + 1);
+    }
+  return lo < hi ? std::pair<int, int>{lo, hi} : std::pair<int, int>{0, 0};
+}
+
+// Avec changeEpsilon = 0, les tuiles sautées n'ont rien à recalculer : le résultat incrémental
+// est celui d'un recalcul complet (changeEpsilon < 0), et les lignes renvoyées couvrent tout ce qui a changé
+static void testIncremental()
+{
+  Simulation sim(N, 1.0f, DT, 0.995f);
+  sim.addDrop(40, 50, 1.0f, 5);
+  DerivedFields incremental(N, 1.0f), full(N, 1.0f);
+  incremental.changeEpsilon = 0.0f;
+  full.changeEpsilon = -1.0f;
+
+  int tiles = (N + DerivedFields::TILE) / DerivedFields::TILE;
+  int mismatches = 0, uncovered = 0, minUpdated = tiles * tiles;
+  for (int frame = 0; frame < 120; ++frame)
+  {
+    sim.advance(DT);
+    std::vector<uint16_t> before = incremental.getPacked();
+    std::pair<int, int> rows = incremental.update(sim, DT);
+    full.update(sim, DT);
+    if (frame > 0)
+      minUpdated = std::min(minUpdated, incremental.getUpdatedTiles());
+
+    mismatches += incremental.getPacked() != full.getPacked() || incremental.getFoam() != full.getFoam();
+    std::pair<int, int> diff = changedRows(before, incremental.getPacked());
+    if (diff.first < diff.second)
+      uncovered += diff.first < rows.first || diff.second > rows.second;
+  }
+  CHECK(minUpdated < tiles * tiles, "toutes les tuiles recalculées à chaque image : rien d'incrémental testé");
+  CHECK(mismatches == 0, "%d images diffèrent du recalcul complet", mismatches);
+  CHECK(uncovered == 0, "%d images modifient des lignes hors de l'intervalle renvoyé", uncovered);
+}
+
+// Source coupée et surface figée : seules les tuiles écumeuses sont recalculées,
+// et l'écume y décroît en exp(-decayRate t)
+static void testFoamDecay()
+{
+  Simulation sim(N, 1.0f, DT, 0.995f);
+  sim.addDrop(64, 64, 1.0f, 5);
+  DerivedFields fields(N, 1.0f);
+  for (int frame = 0; frame < 30; ++frame)
+  {
+    sim.advance(DT);
+    fields.update(sim, DT);
+  }
+  std::vector<float> f0 = fields.getFoam();
+  size_t peak = std::max_element(f0.begin(), f0.end()) - f0.begin();
+  CHECK(f0[peak] > 0.1f, "pas assez d'écume pour le test (%g)", f0[peak]);
+
+  fields.divergenceGain = fields.curvatureGain = 0.0f;
+  const int frames = 40;
+  int kept = 0;
+  for (int frame = 0; frame < frames; ++frame)
+  {
+    std::pair<int, int> rows = fields.update(sim, DT);
+    int y = int(peak) / (N + 1);
+    kept += rows.first <= y && y < rows.second;
+  }
+  double expected = f0[peak] * std::exp(-double(fields.decayRate) * frames * DT);
+  double got = fields.getFoam()[peak];
+  CHECK(kept == frames, "la tuile écumeuse n'est recalculée que %d fois sur %d", kept, frames);
+  CHECK(std::fabs(got - expected) <= 1e-4 * expected, "écume %g au lieu de %g", got, expected);
+  CHECK(fields.getUpdatedTiles() > 0 && fields.getUpdatedTiles() < 20, "%d tuiles recalculées sans changement",
+        fields.getUpdatedTiles());
+}
+
+int main()
+{
+  testIncremental();
+  testFoamDecay();
+  return report("derived");
+}
@@ -0,0 +1,110 @@
+#include "test_common.hpp"
+#include "bathymetry.hpp"
+#include "distributed.hpp"
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+static const int N = 48;
+
+// Le découpage en bandes doit donner exactement la même hauteur qu'un seul processus
+static void testGathered()
+{
+  std::vector<float> depth = makeBasin(N, N * 0.45f, [&](int, int y) { return 0.5f + float(y) / N; });
+
+  for (int s = 0; s < 3; ++s)
+  {
+    for (bool coast : {false, true})
+    {
+      auto body = [&](Simulation &sim) {
+        sim.setIntegrator(schemes[s]);
+        if (coast)
+          sim.setBathymetry(depth);
+        sim.addDrop(17, 30, 1.0f, 5);
+        for (int k = 0; k < 30; ++k)
+          sim.advance(0.016f);
+      };
+      Simulation ref(N, 1.0f, 0.016f, 0.995f);
+      body(ref);
+
+      for (Transport transport : {Transport::SharedMemory, Transport::UnixSocket})
+      {
+        for (int parts : {2, 3, 7})
+        {
+          std::vector<float> h = runDistributed(N, 1.0f, 0.016f, 0.995f, parts, transport, body);
+          size_t diffs = h.size() == ref.getHeight().size() ? 0 : h.size() + 1;
+          for (size_t i = 0; i < h.size() && !diffs; ++i)
+            diffs += h[i] != ref.getHeight()[i];
+          CHECK(diffs == 0, "%s%s, %d bandes (%s) : %zu écarts", schemeNames[s], coast ? " avec côte" : "", parts,
+                transport == Transport::SharedMemory ? "mémoire partagée" : "socket", diffs);
+        }
+      }
+    }
+  }
+}
+
+// Chaque bande lit seulement ses lignes de la carte PGM et ne rassemble rien : même bathymétrie,
+// même sous-pas et même hauteur que la grille entière dans un seul processus
+static void testBandBathymetry()
+{
+  const char *path = "test_distributed_fond.pgm";
+  const int w = 37, hgt = 29;
+  {
+    std::ofstream pgm(path, std::ios::binary);
+    pgm << "P5\n# fond incliné\n" << w << ' ' << hgt << "\n65535\n";
+    for (int y = 0; y < hgt; ++y)
+      for (int x = 0; x < w; ++x)
+      {
+        float r = std::hypot(x - w * 0.5f, y - hgt * 0.5f) / (hgt * 0.5f);
+        uint16_t level = uint16_t(std::min(65535.0f, 65535.0f * (0.1f + 0.5f * r * r + 0.01f * x)));
+        pgm.put(char(level >> 8)).put(char(level & 0xFF));
+      }
+  }
+
+  std::vector<float> heightmap;
+  CHECK(loadHeightmap(path, N, heightmap), "%s illisible", path);
+  std::vector<float> expected = depthFromHeightmap(heightmap, -4.0f, 1.0f);
+
+  Simulation ref(N, 1.0f, 0.016f, 0.995f);
+  CHECK(ref.loadBathymetry(path, -4.0f, 1.0f), "loadBathymetry a échoué");
+  CHECK(ref.getDepth().size() == expected.size(), "profondeur de %zu valeurs", ref.getDepth().size());
+  size_t diffs = 0;
+  for (size_t i = 0; i < expected.size() && i < ref.getDepth().size(); ++i)
+    diffs += ref.getDepth()[i] != (expected[i] < 1e-3f ? 0.0f : expected[i]);
+  CHECK(diffs == 0, "lecture en flux : %zu profondeurs diffèrent de loadHeightmap", diffs);
+
+  for (int s = 0; s < 3; ++s)
+  {
+    auto run = [&](Simulation &sim) {
+      sim.setIntegrator(schemes[s]);
+      sim.addDrop(20, 26, 1.0f, 5);
+      // Pas long : le nombre de sous-pas dépend de la profondeur maximale globale
+      for (int k = 0; k < 20; ++k)
+        sim.advance(0.2f);
+    };
+    Simulation single(N, 1.0f, 0.016f, 0.995f);
+    single.loadBathymetry(path, -4.0f, 1.0f);
+    run(single);
+
+    // Une bande en écart termine son processus en échec
+    bool ok = runDistributedBands(N, 1.0f, 0.016f, 0.995f, 3, Transport::SharedMemory, [&](Simulation &sim) {
+      if (!sim.loadBathymetry(path, -4.0f, 1.0f) || sim.getDepth().size() != sim.getHeight().size())
+        throw std::runtime_error("bathymétrie de la bande");
+      run(sim);
+      int stride = N + 1, offset = sim.getRowOffset();
+      for (int y = sim.getRowBegin(); y < sim.getRowEnd(); ++y)
+        for (int x = 0; x < stride; ++x)
+          if (sim.getHeight()[(y - offset) * stride + x] != single.getHeight()[y * stride + x])
+            throw std::runtime_error("hauteur différente");
+    });
+    CHECK(ok, "%s : bandes chargées séparément différentes d'un seul processus", schemeNames[s]);
+  }
+  std::remove(path);
+}
+
+int main()
+{
+  testGathered();
+  testBandBathymetry();
+  return report("distributed");
+}
@@ -0,0 +1,87 @@
+#include "test_common.hpp"
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+// Compare la hauteur après un nombre fixe de pas à une sortie de référence.
+// test_golden --update régénère tests/data/golden.txt après un changement voulu du schéma.
+static const int N = 64, STEPS = 100, SAMPLE = 4;
+static const float TOLERANCE = 1e-5f;
+
+static std::vector<float> run(int c)
+{
+  Simulation sim(N, 1.0f, 0.016f, 0.995f);
+  if (c < 3)
+    sim.setIntegrator(schemes[c]);
+  else
+  {
+    // Saute-mouton sur un fond en pente bordé de terre
+    sim.setIntegrator(Integrator::StaggeredLeapfrog);
+    sim.setBathymetry(makeBasin(N, N * 0.45f, [](int x, int) { return 0.25f + float(x) / N; }));
+  }
+  sim.addDrop(20, 37, 1.0f, 5);
+  sim.addDrop(45, 25, -0.5f, 3);
+  for (int k = 0; k < STEPS; ++k)
+    sim.advance(0.016f);
+
+  std::vector<float> out;
+  for (int y = 0; y <= N; y += SAMPLE)
+    for (int x = 0; x <= N; x += SAMPLE)
+      out.push_back(sim.getHeight()[y * (N + 1) + x]);
+  return out;
+}
+
+static const char *caseName(int c) { return c < 3 ? schemeNames[c] : "bathymetrie"; }
+
+int main(int argc, char **argv)
+{
+  std::string path = std::string(WATER_TEST_DATA) + "/golden.txt";
+  if (argc > 1 && !std::strcmp(argv[1], "--update"))
+  {
+    std::ofstream file(path);
+    file << "# cas, puis la hauteur toutes les " << SAMPLE << " cellules après " << STEPS
+         << " pas (grille " << N << ")\n";
+    file.precision(9);
+    for (int c = 0; c < 4; ++c)
+    {
+      file << caseName(c);
+      for (float h : run(c))
+        file << ' ' << h;
+      file << '\n';
+    }
+    std::printf("%s régénéré\n", path.c_str());
+    return file ? 0 : 1;
+  }
+
+  std::ifstream file(path);
+  CHECK(bool(file), "%s introuvable", path.c_str());
+  std::map<std::string, std::vector<float>> golden;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::istringstream in(line);
+    std::string name;
+    in >> name;
+    float h;
+    while (in >> h)
+      golden[name].push_back(h);
+  }
+
+  for (int c = 0; c < 4; ++c)
+  {
+    std::vector<float> h = run(c);
+    const std::vector<float> &ref = golden[caseName(c)];
+    CHECK(h.size() == ref.size(), "%s : %zu valeurs au lieu de %zu", caseName(c), h.size(), ref.size());
+    if (h.size() != ref.size())
+      continue;
+    float worst = 0.0f;
+    for (size_t i = 0; i < h.size(); ++i)
+      worst = std::max(worst, std::fabs(h[i] - ref[i]));
+    CHECK(worst <= TOLERANCE, "%s : écart max %g à la référence", caseName(c), worst);
+  }
+  return report("golden");
+}
@@ -0,0 +1,144 @@
+#include "test_common.hpp"
+#include <algorithm>
+
+static const int N = 64;
+
+// Sans amortissement, la masse d'eau ne varie pas tant que l'onde n'atteint pas
+// les bords ; le saute-mouton la conserve aussi avec des murs, tous les schémas avec une côte
+static void testMass()
+{
+  for (int s = 0; s < 3; ++s)
+  {
+    Simulation sim = makeScenario(N, schemes[s], 1.0f, 30, 34);
+    double m0 = totalMass(sim);
+    for (int k = 0; k < 60; ++k)
+      sim.advance(0.016f);
+    double m1 = totalMass(sim);
+    CHECK(std::fabs(m1 - m0) <= 1e-5 * m0, "%s : masse %.9g -> %.9g", schemeNames[s], m0, m1);
+  }
+
+  // La côte est un mur : l'amortissement n'agit que sur u et v, la masse reste
+  std::vector<float> depth = makeBasin(N, N * 0.45f, [](int x, int) { return 0.5f + 0.5f * x / N; });
+  for (int s = 0; s < 3; ++s)
+  {
+    for (bool coast : {false, true})
+    {
+      bool leapfrog = schemes[s] == Integrator::StaggeredLeapfrog;
+      if (!leapfrog && !coast)
+        continue;
+      Simulation sim(N, 1.0f, 0.016f, leapfrog ? 1.0f : 0.995f);
+      sim.setIntegrator(schemes[s]);
+      if (coast)
+        sim.setBathymetry(depth);
+      sim.addDrop(24, 40, 1.0f, 5);
+      double m0 = totalMass(sim);
+      for (int k = 0; k < 3000; ++k)
+        sim.advance(0.016f);
+      double m1 = totalMass(sim);
+      CHECK(std::fabs(m1 - m0) <= 1e-5 * m0, "%s%s : masse %.9g -> %.9g", schemeNames[s], coast ? " (côte)" : "",
+            m0, m1);
+
+      double dry = 0.0;
+      for (size_t i = 0; i < sim.getWetMask().size(); ++i)
+        if (sim.getWetMask()[i] == 0.0f)
+          dry = std::max(dry, double(std::fabs(sim.getHeight()[i])));
+      CHECK(dry == 0.0, "%s : de l'eau sur la terre (%g)", schemeNames[s], dry);
+    }
+  }
+}
+
+// Une goutte au centre d'une grille paire reste symétrique par miroirs et transposition
+static void testSymmetry()
+{
+  for (int s = 0; s < 3; ++s)
+  {
+    Simulation sim = makeScenario(N, schemes[s], 0.995f, N / 2, N / 2);
+    for (int k = 0; k < 200; ++k)
+      sim.advance(0.016f);
+    const std::vector<float> &h = sim.getHeight();
+    float mirror = 0.0f, transpose = 0.0f;
+    for (int y = 0; y <= N; ++y)
+      for (int x = 0; x <= N; ++x)
+      {
+        float a = h[y * (N + 1) + x];
+        mirror = std::max(mirror, std::fabs(a - h[(N - y) * (N + 1) + N - x]));
+        mirror = std::max(mirror, std::fabs(a - h[y * (N + 1) + N - x]));
+        transpose = std::max(transpose, std::fabs(a - h[x * (N + 1) + y]));
+      }
+    CHECK(mirror == 0.0f, "%s : écart miroir %g", schemeNames[s], mirror);
+    CHECK(transpose == 0.0f, "%s : écart transposé %g", schemeNames[s], transpose);
+  }
+}
+
+// L'amortissement d par pas dt atténue u et v ; à l'équipartition, l'énergie
+// décroît comme d^(t / dt). Sans amortissement, les schémas stables la conservent.
+static void testEnergy()
+{
+  const float damping = 0.995f, dt = 0.016f;
+  const int blocks = 10, blockSteps = 50;
+  for (int s = 0; s < 3; ++s)
+  {
+    Simulation sim = makeScenario(N, schemes[s], damping, 28, 35);
+    double e0 = totalEnergy(sim), prev = e0;
+    bool monotonic = true;
+    for (int b = 0; b < blocks; ++b)
+    {
+      for (int k = 0; k < blockSteps; ++k)
+        sim.advance(dt);
+      double e = totalEnergy(sim);
+      monotonic = monotonic && e < prev;
+      prev = e;
+    }
+    double rate = -std::log(prev / e0) / (blocks * blockSteps);
+    double expected = -std::log(double(damping));
+    CHECK(monotonic, "%s : l'énergie amortie augmente", schemeNames[s]);
+    CHECK(rate > 0.75 * expected && rate < 1.25 * expected, "%s : taux de décroissance %g au lieu de %g",
+          schemeNames[s], rate, expected);
+  }
+
+  for (int s : {1, 2})
+  {
+    Simulation sim = makeScenario(N, schemes[s], 1.0f, 28, 35);
+    double e0 = totalEnergy(sim), drift = 0.0;
+    for (int b = 0; b < blocks; ++b)
+    {
+      for (int k = 0; k < blockSteps; ++k)
+        sim.advance(dt);
+      drift = std::max(drift, std::fabs(totalEnergy(sim) / e0 - 1.0));
+    }
+    CHECK(drift < 0.01, "%s : dérive d'énergie %g sans amortissement", schemeNames[s], drift);
+  }
+}
+
+// advance() sur plusieurs pas dt : chaque schéma se découpe en sous-pas qui restent stables.
+// Une instabilité d'Euler limitée par l'amortissement croît lentement : on vérifie l'énergie
+// à intervalles réguliers sur des milliers d'appels.
+static void testSubSteps()
+{
+  const int calls = 2000, checkEvery = 250;
+  for (int s = 0; s < 3; ++s)
+  {
+    Simulation sim(N, 1.0f, 0.05f, 0.995f);
+    sim.setIntegrator(schemes[s]);
+    sim.addDrop(28, 35, 1.0f, 5);
+    double e0 = totalEnergy(sim), e = e0;
+    int minSteps = 1 << 30;
+    for (int k = 1; k <= calls && std::isfinite(e) && e <= e0; ++k)
+    {
+      minSteps = std::min(minSteps, sim.advance(0.5f));
+      if (k % checkEvery == 0)
+        e = totalEnergy(sim);
+    }
+    CHECK(minSteps > 1, "%s : advance() n'a pas découpé le pas", schemeNames[s]);
+    CHECK(std::isfinite(e) && e <= e0, "%s : énergie %g -> %g en sous-pas", schemeNames[s], e0, e);
+  }
+}
+
+int main()
+{
+  testMass();
+  testSymmetry();
+  testEnergy();
+  testSubSteps();
+  return report("invariants");
+}
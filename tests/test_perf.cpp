@@ -0,0 +1,84 @@
+#include "test_common.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+
+// Débit du solveur (cellules mises à jour par seconde) comparé à tests/data/perf_baseline.txt.
+// Échoue si un schéma perd plus de WATER_PERF_TOLERANCE (0.3 par défaut) de son débit de référence.
+// test_perf --update enregistre les débits de la machine courante comme nouvelle référence.
+static const int N = 256;
+
+static double cellsPerSecond(int s, const char *name, bool bathymetry)
+{
+  double best = 0.0;
+  for (int run = 0; run < 3; ++run)
+  {
+    Simulation sim = makeScenario(N, schemes[s], 0.995f, N / 2, N / 3);
+    if (bathymetry)
+      sim.setBathymetry(std::vector<float>((N + 1) * (N + 1), 1.0f));
+    long long steps = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    while (elapsed < 0.2)
+    {
+      for (int k = 0; k < 10; ++k)
+        steps += sim.advance(0.016f);
+      elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    best = std::max(best, double(steps) * (N + 1) * (N + 1) / elapsed);
+  }
+  std::printf("%-22s %8.1f Mcellules/s\n", name, best * 1e-6);
+  return best;
+}
+
+int main(int argc, char **argv)
+{
+#ifndef NDEBUG
+  std::printf("perf : ignoré hors compilation optimisée\n");
+  return 77;
+#endif
+  std::string path = std::string(WATER_TEST_DATA) + "/perf_baseline.txt";
+  std::map<std::string, double> measured;
+  for (int s = 0; s < 3; ++s)
+  {
+    measured[schemeNames[s]] = cellsPerSecond(s, schemeNames[s], false);
+    std::string name = std::string(schemeNames[s]) + "-bathymetrie";
+    measured[name] = cellsPerSecond(s, name.c_str(), true);
+  }
+
+  if (argc > 1 && !std::strcmp(argv[1], "--update"))
+  {
+    std::ofstream file(path);
+    file << "# schéma, cellules par seconde (test_perf --update)\n";
+    for (auto &[name, rate] : measured)
+      file << name << ' ' << rate << '\n';
+    std::printf("%s régénéré\n", path.c_str());
+    return file ? 0 : 1;
+  }
+
+  const char *env = std::getenv("WATER_PERF_TOLERANCE");
+  double tolerance = env ? std::atof(env) : 0.3;
+  std::ifstream file(path);
+  CHECK(bool(file), "%s introuvable", path.c_str());
+  std::string name;
+  double baseline;
+  while (file >> name)
+  {
+    if (name[0] == '#')
+    {
+      file.ignore(1 << 20, '\n');
+      continue;
+    }
+    if (!(file >> baseline))
+      break;
+    auto it = measured.find(name);
+    CHECK(it != measured.end(), "référence inconnue : %s", name.c_str());
+    if (it != measured.end())
+      CHECK(it->second >= (1.0 - tolerance) * baseline, "%s : %.1f Mcellules/s pour %.1f de référence",
+            name.c_str(), it->second * 1e-6, baseline * 1e-6);
+  }
+  return report("perf");
+}
@@ -0,0 +1,108 @@
+#include "test_common.hpp"
+#include "water_query.hpp"
+#include <random>
+
+static const int N = 64;
+static const float DX = 0.5f;
+
+static float worldX(float gx) { return (gx - N * 0.5f) * DX; }
+
+static Simulation makeSurface(Integrator scheme, bool coast)
+{
+  Simulation sim(N, DX, 0.016f, 0.995f);
+  sim.setIntegrator(scheme);
+  if (coast)
+    sim.setBathymetry(makeBasin(N, N * 0.45f, [](int x, int) { return 1.5f - float(x) / N; }));
+  sim.addDrop(25, 38, 1.0f, 5);
+  sim.addDrop(40, 22, -0.7f, 4);
+  for (int k = 0; k < 40; ++k)
+    sim.advance(0.016f);
+  return sim;
+}
+
+// Lots (AVX2 si disponible) et chemin scalaire, y compris hors grille et NaN
+static void testBatchMatchesScalar(const SurfaceSnapshot &surface, const char *name)
+{
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> pos(-0.6f * N * DX, 0.6f * N * DX);
+  size_t count = 4099;
+  std::vector<float> xs(count), zs(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    xs[i] = pos(rng);
+    zs[i] = pos(rng);
+  }
+  xs[5] = zs[9] = std::nanf("");
+  std::vector<WaterSample> batch(count), scalar(count);
+  surface.sample(xs.data(), zs.data(), count, batch.data(), 1);
+  surface.sampleScalar(xs.data(), zs.data(), count, scalar.data());
+
+  float worst = 0.0f;
+  bool finite = true;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const WaterSample &a = batch[i], &b = scalar[i];
+    for (auto [p, q] : {std::pair(a.height, b.height), std::pair(a.slopeX, b.slopeX), std::pair(a.slopeZ, b.slopeZ),
+                        std::pair(a.velX, b.velX), std::pair(a.velZ, b.velZ)})
+    {
+      finite = finite && std::isfinite(p) && std::isfinite(q);
+      worst = std::max(worst, std::fabs(p - q));
+    }
+  }
+  CHECK(finite, "%s : échantillon non fini", name);
+  CHECK(worst <= 1e-5f, "%s : lots et scalaire diffèrent de %g", name, worst);
+}
+
+// Aux nœuds, la hauteur est celle stockée ; u et v sont lus à leur position,
+// décalée d'une demi-maille sur la grille C
+static void testNodes(const Simulation &sim, const char *name)
+{
+  SurfaceSnapshot surface(sim);
+  const std::vector<float> &h = sim.getHeight(), &u = sim.getU(), &v = sim.getV();
+  float shift = sim.getIntegrator() == Integrator::StaggeredLeapfrog ? 0.5f : 0.0f;
+  int bad = 0, badDirect = 0;
+  for (int y = 1; y < N - 1; y += 3)
+    for (int x = 1; x < N - 1; x += 3)
+    {
+      int i = y * (N + 1) + x;
+      bad += surface.sample(worldX(x), worldX(y)).height != h[i];
+      bad += surface.sample(worldX(x + shift), worldX(y)).velX != u[i];
+      bad += surface.sample(worldX(x), worldX(y + shift)).velZ != v[i];
+
+      WaterSample a = surface.sample(worldX(x + 0.3f), worldX(y + 0.6f));
+      WaterSample b = sampleSurface(sim, worldX(x + 0.3f), worldX(y + 0.6f));
+      badDirect += a.height != b.height || a.velX != b.velX || a.velZ != b.velZ;
+    }
+  CHECK(bad == 0, "%s : %d valeurs aux nœuds différentes des champs stockés", name, bad);
+  CHECK(badDirect == 0, "%s : %d écarts entre sampleSurface et l'instantané", name, badDirect);
+}
+
+int main()
+{
+  for (int s = 0; s < 3; ++s)
+  {
+    Simulation sim = makeSurface(schemes[s], false);
+    testBatchMatchesScalar(SurfaceSnapshot(sim), schemeNames[s]);
+    testNodes(sim, schemeNames[s]);
+  }
+
+  // Avec une bathymétrie, u et v sont des débits : l'instantané et la lecture directe rendent des vitesses.
+  // Sur la grille C, u est divisé par la profondeur de sa face, min des deux cellules : le fond remonte
+  // vers +x pour qu'elle diffère de celle de la cellule.
+  Simulation sim = makeSurface(Integrator::StaggeredLeapfrog, true);
+  SurfaceSnapshot surface(sim);
+  testBatchMatchesScalar(surface, "bathymetrie");
+  const std::vector<float> &depth = sim.getDepth();
+  int x = 30, y = 33, i = y * (N + 1) + x;
+  float faceU = std::min(depth[i], depth[i + 1]), faceV = std::min(depth[i], depth[i + N + 1]);
+  float velX = sim.getU()[i] / faceU, velZ = sim.getV()[i] / faceV;
+  CHECK(faceU < depth[i], "bathymetrie : la face de u doit être moins profonde que la cellule");
+  WaterSample a = surface.sample(worldX(x + 0.5f), worldX(y)), b = sampleSurface(sim, worldX(x + 0.5f), worldX(y));
+  CHECK(a.velX == velX, "bathymetrie : vitesse %g au nœud de u au lieu de %g", a.velX, velX);
+  CHECK(b.velX == velX, "bathymetrie : vitesse directe %g au nœud de u au lieu de %g", b.velX, velX);
+  a = surface.sample(worldX(x), worldX(y + 0.5f));
+  b = sampleSurface(sim, worldX(x), worldX(y + 0.5f));
+  CHECK(a.velZ == velZ && b.velZ == velZ, "bathymetrie : vitesse %g / %g au nœud de v au lieu de %g", a.velZ,
+        b.velZ, velZ);
+  return report("query");
+}